@@ -0,0 +1,580 @@
+#include "graph.h"
+#include "graph_algorithms.h"
+#include "graph_dumb_vector.h"
+#include "graph_generators.h"
+#include "property_map.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+using namespace std;
+using namespace chrono;
+
+// Benchmark suite for the graph backends. Every (backend, generator, size)
+// case is built and exercised warmup + reps times; each phase of each run is
+// timed on its own and its heap allocations and peak RSS are recorded. The
+// summary (median/p95/p99 and friends) goes to a table, CSV or JSON, and a CSV
+// from an earlier build can be given as a baseline, in which case each phase
+// is compared with a Mann-Whitney U test so real regressions stand out from
+// run-to-run noise.
+//
+// Run ./benchmark.o --help for the options.
+
+////////////////////////////////////////////////////////////////////////////////
+// Allocation counting: every global new in this program goes through here.
+// The deletes are kept out of line so GCC does not pair an inlined free()
+// with the builtin new and warn about a mismatch.
+////////////////////////////////////////////////////////////////////////////////
+
+static atomic<size_t> g_allocations(0);
+static atomic<size_t> g_allocated_bytes(0);
+
+void *operator new(size_t n)
+{
+    g_allocations.fetch_add(1, memory_order_relaxed);
+    g_allocated_bytes.fetch_add(n, memory_order_relaxed);
+    if (void *p = malloc(n ? n : 1))
+        return p;
+    throw bad_alloc();
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept
+{
+    free(p);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Peak RSS: on Linux VmHWM can be reset per phase through clear_refs,
+// elsewhere the process-wide maximum is reported.
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Reset the peak-RSS watermark, if the platform allows it
+void reset_peak_rss()
+{
+    ofstream clear_refs("/proc/self/clear_refs");
+    if (clear_refs)
+        clear_refs << "5";
+}
+
+/// @brief Peak resident set size in KiB since the last reset
+size_t peak_rss_kib()
+{
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line))
+        if (line.compare(0, 6, "VmHWM:") == 0)
+            return strtoull(line.c_str() + 6, nullptr, 10);
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Measurements and statistics
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief One timed phase of one run
+struct sample
+{
+    double seconds;
+    size_t allocations;
+    size_t bytes;
+    size_t peak_rss;
+};
+
+/// @brief Times a phase and attributes allocations and peak RSS to it
+class phase_timer
+{
+  public:
+    phase_timer()
+    {
+        reset_peak_rss();
+        m_allocations = g_allocations.load();
+        m_bytes = g_allocated_bytes.load();
+        m_start = steady_clock::now();
+    }
+
+    sample stop() const
+    {
+        steady_clock::time_point stop = steady_clock::now();
+        return {duration_cast<duration<double>>(stop - m_start).count(),
+                g_allocations.load() - m_allocations,
+                g_allocated_bytes.load() - m_bytes,
+                peak_rss_kib()};
+    }
+
+  private:
+    steady_clock::time_point m_start;
+    size_t m_allocations;
+    size_t m_bytes;
+};
+
+/// @brief Linearly interpolated percentile of sorted values, q in [0, 1]
+double percentile(const vector<double> &sorted, double q)
+{
+    if (sorted.empty())
+        return 0;
+    double pos = q * (sorted.size() - 1);
+    size_t lo = size_t(pos);
+    size_t hi = min(lo + 1, sorted.size() - 1);
+    return sorted[lo] + (pos - lo) * (sorted[hi] - sorted[lo]);
+}
+
+/// @brief Summary of the samples of one phase
+struct summary
+{
+    double min, median, mean, p95, p99, max, stddev, mad;
+    size_t allocations, bytes, peak_rss;
+};
+
+summary summarize(const vector<sample> &samples)
+{
+    vector<double> t;
+    summary s = {};
+    for (const sample &x : samples)
+    {
+        t.push_back(x.seconds);
+        s.allocations = max(s.allocations, x.allocations);
+        s.bytes = max(s.bytes, x.bytes);
+        s.peak_rss = max(s.peak_rss, x.peak_rss);
+    }
+    sort(t.begin(), t.end());
+    s.min = t.front();
+    s.max = t.back();
+    s.median = percentile(t, 0.5);
+    s.p95 = percentile(t, 0.95);
+    s.p99 = percentile(t, 0.99);
+    for (double x : t)
+        s.mean += x / t.size();
+    for (double x : t)
+        s.stddev += (x - s.mean) * (x - s.mean);
+    s.stddev = t.size() > 1 ? sqrt(s.stddev / (t.size() - 1)) : 0;
+    vector<double> dev;
+    for (double x : t)
+        dev.push_back(fabs(x - s.median));
+    sort(dev.begin(), dev.end());
+    s.mad = percentile(dev, 0.5);
+    return s;
+}
+
+/// @brief Two-sided Mann-Whitney U test p-value (normal approximation with
+///        tie correction); no assumption about the shape of the timing noise
+double mann_whitney_p(const vector<double> &a, const vector<double> &b)
+{
+    size_t n1 = a.size(), n2 = b.size(), n = n1 + n2;
+    if (n1 == 0 || n2 == 0)
+        return 1;
+    vector<pair<double, int>> all;
+    for (double x : a)
+        all.emplace_back(x, 0);
+    for (double x : b)
+        all.emplace_back(x, 1);
+    sort(all.begin(), all.end());
+
+    double rank_sum = 0, tie_term = 0;
+    for (size_t i = 0; i < n;)
+    {
+        size_t j = i;
+        while (j < n && all[j].first == all[i].first)
+            ++j;
+        double rank = (i + j + 1) / 2.0;
+        for (size_t k = i; k < j; ++k)
+            if (all[k].second == 0)
+                rank_sum += rank;
+        double t = j - i;
+        tie_term += t * t * t - t;
+        i = j;
+    }
+    double u = rank_sum - n1 * (n1 + 1) / 2.0;
+    double mean = n1 * n2 / 2.0;
+    double var = n1 * n2 / 12.0 * ((n + 1) - tie_term / (n * (n - 1.0)));
+    if (var <= 0)
+        return 1;
+    double z = (fabs(u - mean) - 0.5) / sqrt(var);
+    return erfc(max(z, 0.0) / sqrt(2.0));
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Cases
+////////////////////////////////////////////////////////////////////////////////
+
+const char *const phase_names[] = {"create", "bfs", "dfs", "erase_edge", "erase_vertex"};
+const size_t num_phases = sizeof(phase_names) / sizeof(phase_names[0]);
+
+/// @brief Results of one (backend, generator, size) case
+struct case_result
+{
+    string backend, generator;
+    size_t size;
+    vector<sample> phases[num_phases];
+};
+
+typedef function<void(size_t, unsigned, vector<sample> *)> case_runner;
+
+/// @brief One run of every phase on a freshly generated graph
+template <typename graph_id, typename Initializer>
+void run_once(Initializer init, size_t n, unsigned seed, vector<sample> *out)
+{
+    typedef typename graph_id::vertex_descriptor vertex_descriptor;
+    vector_property_map<vertex_descriptor, vertex_descriptor> parent_map;
+    srand(seed);
+    mt19937 rng(seed);
+
+    phase_timer create;
+    graph_id g;
+    init(g, n);
+    out[0].push_back(create.stop());
+
+    phase_timer bfs;
+    breadth_first_search(g, parent_map);
+    out[1].push_back(bfs.stop());
+
+    phase_timer dfs;
+    depth_first_search(g, parent_map);
+    out[2].push_back(dfs.stop());
+
+    // erase a quarter of the edges, then a quarter of the vertices, picking
+    // victims up front so the lookups are not part of the measurement
+    vector<typename graph_id::edge_descriptor> edges;
+    for (auto ei = g.edges_cbegin(); ei != g.edges_cend(); ++ei)
+        edges.push_back((*ei)->descriptor());
+    shuffle(edges.begin(), edges.end(), rng);
+    edges.resize(edges.size() / 4);
+    phase_timer erase_edge;
+    for (const auto &ed : edges)
+        g.erase_edge(ed);
+    out[3].push_back(erase_edge.stop());
+
+    vector<vertex_descriptor> vertices;
+    for (auto vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi)
+        vertices.push_back((*vi)->descriptor());
+    shuffle(vertices.begin(), vertices.end(), rng);
+    vertices.resize(vertices.size() / 4);
+    phase_timer erase_vertex;
+    for (vertex_descriptor vd : vertices)
+        g.erase_vertex(vd);
+    out[4].push_back(erase_vertex.stop());
+}
+
+/// @brief Runner for a backend/generator pair
+template <typename graph_id>
+case_runner make_runner(const string &generator)
+{
+    void (*init)(graph_id &, size_t) = nullptr;
+    if (generator == "complete")
+        init = initialize_complete_graph<graph_id>;
+    else if (generator == "mesh")
+        init = initialize_mesh_graph<graph_id>;
+    else if (generator == "random")
+        init = initialize_random_graph<graph_id>;
+    else if (generator == "rmat")
+        init = initialize_rmat_graph<graph_id>;
+    else if (generator == "er")
+        init = initialize_erdos_renyi_graph<graph_id>;
+    else if (generator == "grid3d")
+        init = initialize_grid3d_graph<graph_id>;
+    else if (generator == "powerlaw")
+        init = initialize_power_law_graph<graph_id>;
+    if (!init)
+        return case_runner();
+    return [init](size_t n, unsigned seed, vector<sample> *out) {
+        run_once<graph_id>(init, n, seed, out);
+    };
+}
+
+/// @brief Registry of backends; add a line here for a new graph type
+case_runner find_runner(const string &backend, const string &generator)
+{
+    if (backend == "set")
+        return make_runner<graph<int, double>>(generator);
+    if (backend == "vector")
+        return make_runner<graph_vector<int, double>>(generator);
+    return case_runner();
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Output
+////////////////////////////////////////////////////////////////////////////////
+
+void write_table(ostream &os, const vector<case_result> &results)
+{
+    os << left << setw(8) << "backend" << setw(10) << "generator" << setw(8) << "size"
+       << setw(14) << "phase" << right << setw(12) << "median" << setw(12) << "p95"
+       << setw(12) << "p99" << setw(10) << "mad%" << setw(12) << "allocs" << setw(12)
+       << "rss(KiB)" << endl;
+    for (const case_result &r : results)
+        for (size_t p = 0; p < num_phases; ++p)
+        {
+            summary s = summarize(r.phases[p]);
+            os << left << setw(8) << r.backend << setw(10) << r.generator << setw(8) << r.size
+               << setw(14) << phase_names[p] << right << scientific << setprecision(3)
+               << setw(12) << s.median << setw(12) << s.p95 << setw(12) << s.p99 << fixed
+               << setprecision(2) << setw(10) << (s.median > 0 ? 100 * s.mad / s.median : 0)
+               << setw(12) << s.allocations << setw(12) << s.peak_rss << endl;
+        }
+}
+
+/// @brief One row per phase; samples are kept so the file can be a baseline
+void write_csv(ostream &os, const vector<case_result> &results)
+{
+    os << "backend,generator,size,phase,reps,min,median,mean,p95,p99,max,stddev,mad,"
+          "allocations,bytes,peak_rss_kib,samples"
+       << endl;
+    os << setprecision(9);
+    for (const case_result &r : results)
+        for (size_t p = 0; p < num_phases; ++p)
+        {
+            summary s = summarize(r.phases[p]);
+            os << r.backend << "," << r.generator << "," << r.size << "," << phase_names[p] << ","
+               << r.phases[p].size() << "," << s.min << "," << s.median << "," << s.mean << ","
+               << s.p95 << "," << s.p99 << "," << s.max << "," << s.stddev << "," << s.mad << ","
+               << s.allocations << "," << s.bytes << "," << s.peak_rss << ",";
+            for (size_t i = 0; i < r.phases[p].size(); ++i)
+                os << (i ? ";" : "") << r.phases[p][i].seconds;
+            os << endl;
+        }
+}
+
+void write_json(ostream &os, const vector<case_result> &results)
+{
+    os << setprecision(9) << "[";
+    bool first = true;
+    for (const case_result &r : results)
+        for (size_t p = 0; p < num_phases; ++p)
+        {
+            summary s = summarize(r.phases[p]);
+            os << (first ? "\n" : ",\n") << "  {\"backend\": \"" << r.backend
+               << "\", \"generator\": \"" << r.generator << "\", \"size\": " << r.size
+               << ", \"phase\": \"" << phase_names[p] << "\", \"reps\": " << r.phases[p].size()
+               << ", \"min\": " << s.min << ", \"median\": " << s.median << ", \"mean\": " << s.mean
+               << ", \"p95\": " << s.p95 << ", \"p99\": " << s.p99 << ", \"max\": " << s.max
+               << ", \"stddev\": " << s.stddev << ", \"mad\": " << s.mad
+               << ", \"allocations\": " << s.allocations << ", \"bytes\": " << s.bytes
+               << ", \"peak_rss_kib\": " << s.peak_rss << ", \"samples\": [";
+            for (size_t i = 0; i < r.phases[p].size(); ++i)
+                os << (i ? ", " : "") << r.phases[p][i].seconds;
+            os << "]}";
+            first = false;
+        }
+    os << "\n]" << endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Baseline comparison
+////////////////////////////////////////////////////////////////////////////////
+
+/// @brief Samples of a CSV written by write_csv, keyed by backend/generator/size/phase
+map<string, vector<double>> read_baseline(const string &path)
+{
+    map<string, vector<double>> baseline;
+    ifstream is(path);
+    if (!is)
+    {
+        cerr << "Error. Cannot read baseline " << path << endl;
+        exit(-1);
+    }
+    string line;
+    getline(is, line);
+    while (getline(is, line))
+    {
+        vector<string> fields;
+        stringstream ss(line);
+        string field;
+        while (getline(ss, field, ','))
+            fields.push_back(field);
+        if (fields.size() < 17)
+            continue;
+        vector<double> &samples = baseline[fields[0] + "," + fields[1] + "," + fields[2] + "," + fields[3]];
+        stringstream ts(fields[16]);
+        while (getline(ts, field, ';'))
+            samples.push_back(atof(field.c_str()));
+    }
+    return baseline;
+}
+
+/// @brief Flag a phase only if it moved by more than threshold and the
+///        change is significant at level alpha
+void compare(ostream &os, const vector<case_result> &results, const string &path,
+             double threshold, double alpha)
+{
+    map<string, vector<double>> baseline = read_baseline(path);
+    os << "\nComparison with " << path << " (threshold " << 100 * threshold << "%, alpha "
+       << alpha << ")" << endl;
+    for (const case_result &r : results)
+        for (size_t p = 0; p < num_phases; ++p)
+        {
+            ostringstream key;
+            key << r.backend << "," << r.generator << "," << r.size << "," << phase_names[p];
+            auto b = baseline.find(key.str());
+            if (b == baseline.end())
+                continue;
+            vector<double> current;
+            for (const sample &x : r.phases[p])
+                current.push_back(x.seconds);
+            vector<double> old = b->second;
+            sort(current.begin(), current.end());
+            sort(old.begin(), old.end());
+            double change = percentile(current, 0.5) / percentile(old, 0.5) - 1;
+            double pvalue = mann_whitney_p(current, old);
+            const char *verdict = "noise";
+            if (pvalue < alpha && fabs(change) > threshold)
+                verdict = change > 0 ? "REGRESSION" : "improvement";
+            os << "\t" << key.str() << "\t" << showpos << fixed << setprecision(2) << 100 * change
+               << "%" << noshowpos << "\tp=" << setprecision(4) << pvalue << "\t" << verdict << endl;
+        }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Driver
+////////////////////////////////////////////////////////////////////////////////
+
+vector<string> split(const string &s)
+{
+    vector<string> out;
+    stringstream ss(s);
+    string item;
+    while (getline(ss, item, ','))
+        if (!item.empty())
+            out.push_back(item);
+    return out;
+}
+
+void usage()
+{
+    cerr << "Usage: ./benchmark.o [options]\n"
+            "  --backends set,vector        graph backends to run\n"
+            "  --generators complete,mesh,random (also rmat, er, grid3d, powerlaw)\n"
+            "  --sizes N,...                vertex counts (default 100,400)\n"
+            "  --warmup N                   discarded runs per case (default 2)\n"
+            "  --reps N                     measured runs per case (default 15)\n"
+            "  --seed S                     srand() seed for each run (default 0)\n"
+            "  --format table|csv|json      (default table)\n"
+            "  --output FILE                write results to FILE instead of stdout\n"
+            "  --baseline FILE              compare with a CSV from an earlier run\n"
+            "  --threshold F                smallest relative change to flag (default 0.02)\n"
+            "  --alpha F                    significance level (default 0.01)\n"
+            "Example: ./benchmark.o --generators random --sizes 800 --reps 30 --format csv --output base.csv"
+         << endl;
+}
+
+int main(int argc, char **argv)
+{
+    vector<string> backends = {"set", "vector"};
+    vector<string> generators = {"complete", "mesh", "random"};
+    vector<size_t> sizes = {100, 400};
+    size_t warmup = 2, reps = 15;
+    unsigned seed = 0;
+    string format = "table", output, baseline;
+    double threshold = 0.02, alpha = 0.01;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--help")
+        {
+            usage();
+            return 0;
+        }
+        if (i + 1 >= argc)
+        {
+            usage();
+            return -1;
+        }
+        string value = argv[++i];
+        if (arg == "--backends")
+            backends = split(value);
+        else if (arg == "--generators")
+            generators = split(value);
+        else if (arg == "--sizes")
+        {
+            sizes.clear();
+            for (const string &s : split(value))
+                sizes.push_back(strtoull(s.c_str(), nullptr, 10));
+        }
+        else if (arg == "--warmup")
+            warmup = atoi(value.c_str());
+        else if (arg == "--reps")
+            reps = max(1, atoi(value.c_str()));
+        else if (arg == "--seed")
+            seed = atoi(value.c_str());
+        else if (arg == "--format")
+            format = value;
+        else if (arg == "--output")
+            output = value;
+        else if (arg == "--baseline")
+            baseline = value;
+        else if (arg == "--threshold")
+            threshold = atof(value.c_str());
+        else if (arg == "--alpha")
+            alpha = atof(value.c_str());
+        else
+        {
+            usage();
+            return -1;
+        }
+    }
+    if (format != "table" && format != "csv" && format != "json")
+    {
+        usage();
+        return -1;
+    }
+
+    vector<case_result> results;
+    for (const string &backend : backends)
+        for (const string &generator : generators)
+        {
+            case_runner run = find_runner(backend, generator);
+            if (!run)
+            {
+                cerr << "Error. Unknown backend/generator " << backend << "/" << generator << endl;
+                return -1;
+            }
+            for (size_t n : sizes)
+            {
+                cerr << backend << " " << generator << " " << n << "..." << endl;
+                case_result r = {backend, generator, n, {}};
+                vector<sample> discard[num_phases];
+                for (size_t i = 0; i < warmup; ++i)
+                    run(n, seed, discard);
+                for (size_t i = 0; i < reps; ++i)
+                    run(n, seed, r.phases);
+                results.push_back(move(r));
+            }
+        }
+
+    ofstream file;
+    if (!output.empty())
+        file.open(output);
+    ostream &os = output.empty() ? cout : file;
+    if (format == "csv")
+        write_csv(os, results);
+    else if (format == "json")
+        write_json(os, results);
+    else
+        write_table(os, results);
+
+    if (!baseline.empty())
+        compare(cout, results, baseline, threshold, alpha);
+}
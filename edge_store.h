@@ -0,0 +1,417 @@
+#ifndef _EDGE_STORE_H_
+#define _EDGE_STORE_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
+#include "graph_algorithms.h"
+
+
+// Structure-of-arrays edge storage and bulk kernels over it. The graphs keep
+// each edge's endpoints and property together in one node, so a pass over
+// the weights alone drags the endpoints through the cache with them.
+// edge_store copies g's out-edges into a target array and a parallel weight
+// array, grouped by source, and the kernels below stream those arrays.
+//
+// For double weights the kernels have AVX2 and AVX-512 forms, chosen at run
+// time from what the processor supports (and capped by
+// set_simd_kernel_level); every other weight type, and every other
+// processor, takes the scalar loop. The forms give identical results.
+
+static const int simd_scalar = 0;  //< Plain loops
+static const int simd_avx2 = 1;    //< 4 doubles per instruction
+static const int simd_avx512 = 2;  //< 8 doubles per instruction
+
+inline int& simd_kernel_cap() {
+  static int cap = simd_avx512;
+  return cap;
+}
+
+///@brief Most capable kernel form the processor supports, within the cap.
+inline int simd_kernel_level() {
+#if defined(__x86_64__) && defined(__GNUC__)
+  static const int supported = __builtin_cpu_supports("avx512f") ? simd_avx512
+    : __builtin_cpu_supports("avx2") ? simd_avx2 : simd_scalar;
+#else
+  static const int supported = simd_scalar;
+#endif
+  return std::min(supported, simd_kernel_cap());
+}
+
+///@brief Use no kernel form above level, e.g. to compare against scalar.
+inline void set_simd_kernel_level(int level) {simd_kernel_cap() = level;}
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// Kernels over raw arrays: n edges with targets t and weights w.
+////////////////////////////////////////////////////////////////////////////////
+
+///@brief For each edge i with base + w[i] < dist[t[i]], lower dist[t[i]] to
+///       it and append t[i] to improved (room for n). Returns the number
+///       appended; a target reached by several edges may appear more than once.
+template<typename Weight>
+  size_t relax_edges_scalar(const size_t* t, const Weight* w, size_t n, Weight base,
+      Weight* dist, size_t* improved) {
+    size_t k = 0;
+    for(size_t i = 0; i < n; ++i) {
+      Weight c = base + w[i];
+      if(c < dist[t[i]]) {
+        dist[t[i]] = c;
+        improved[k++] = t[i];
+      }
+    }
+    return k;
+  }
+
+///@brief Position of the smallest of n weights (the first, on ties); n if
+///       there are none.
+template<typename Weight>
+  size_t min_weight_scalar(const Weight* w, size_t n) {
+    return std::min_element(w, w + n) - w;
+  }
+
+///@brief Multiply n weights by factor in place.
+template<typename Weight>
+  void scale_weights_scalar(Weight* w, size_t n, Weight factor) {
+    for(size_t i = 0; i < n; ++i)
+      w[i] *= factor;
+  }
+
+///@brief Append to out (room for n) the positions i with w[i] < threshold,
+///       in order. Returns the number appended.
+template<typename Weight>
+  size_t select_below_scalar(const Weight* w, size_t n, Weight threshold, size_t* out) {
+    size_t k = 0;
+    for(size_t i = 0; i < n; ++i)
+      if(w[i] < threshold)
+        out[k++] = i;
+    return k;
+  }
+
+#if defined(__x86_64__) && defined(__GNUC__)
+// The vector forms compare a whole register at once and finish each lane
+// that passes in scalar code, so repeated targets within one register and
+// the order of appended results behave exactly as in the scalar loops.
+//
+// GCC 12's AVX-512 intrinsics start from _mm512_undefined_pd(), which trips
+// -Wmaybe-uninitialized in every caller.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+__attribute__((target("avx2")))
+inline size_t relax_edges_avx2(const size_t* t, const double* w, size_t n, double base,
+    double* dist, size_t* improved) {
+  size_t i = 0, k = 0;
+  const __m256d b = _mm256_set1_pd(base);
+  for(; i + 4 <= n; i += 4) {
+    __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t + i));
+    __m256d current = _mm256_i64gather_pd(dist, index, 8);
+    __m256d candidate = _mm256_add_pd(b, _mm256_loadu_pd(w + i));
+    for(int m = _mm256_movemask_pd(_mm256_cmp_pd(candidate, current, _CMP_LT_OQ)); m; m &= m - 1) {
+      size_t j = i + __builtin_ctz(m);
+      k += relax_edges_scalar(t + j, w + j, 1, base, dist, improved + k);
+    }
+  }
+  return k + relax_edges_scalar(t + i, w + i, n - i, base, dist, improved + k);
+}
+
+__attribute__((target("avx512f")))
+inline size_t relax_edges_avx512(const size_t* t, const double* w, size_t n, double base,
+    double* dist, size_t* improved) {
+  size_t i = 0, k = 0;
+  const __m512d b = _mm512_set1_pd(base);
+  for(; i + 8 <= n; i += 8) {
+    __m512i index = _mm512_loadu_si512(t + i);
+    __m512d current = _mm512_i64gather_pd(index, dist, 8);
+    __m512d candidate = _mm512_add_pd(b, _mm512_loadu_pd(w + i));
+    for(unsigned m = _mm512_cmp_pd_mask(candidate, current, _CMP_LT_OQ); m; m &= m - 1) {
+      size_t j = i + __builtin_ctz(m);
+      k += relax_edges_scalar(t + j, w + j, 1, base, dist, improved + k);
+    }
+  }
+  return k + relax_edges_scalar(t + i, w + i, n - i, base, dist, improved + k);
+}
+
+__attribute__((target("avx2")))
+inline size_t min_weight_avx2(const double* w, size_t n) {
+  if(n < 8)
+    return min_weight_scalar(w, n);
+  __m256d low = _mm256_loadu_pd(w);
+  size_t i = 4;
+  for(; i + 4 <= n; i += 4)
+    low = _mm256_min_pd(low, _mm256_loadu_pd(w + i));
+  double lanes[4];
+  _mm256_storeu_pd(lanes, low);
+  double best = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+  for(; i < n; ++i)
+    best = std::min(best, w[i]);
+  return std::find(w, w + n, best) - w;
+}
+
+__attribute__((target("avx512f")))
+inline size_t min_weight_avx512(const double* w, size_t n) {
+  if(n < 16)
+    return min_weight_scalar(w, n);
+  __m512d low = _mm512_loadu_pd(w);
+  size_t i = 8;
+  for(; i + 8 <= n; i += 8)
+    low = _mm512_min_pd(low, _mm512_loadu_pd(w + i));
+  double best = _mm512_reduce_min_pd(low);
+  for(; i < n; ++i)
+    best = std::min(best, w[i]);
+  return std::find(w, w + n, best) - w;
+}
+
+__attribute__((target("avx2")))
+inline void scale_weights_avx2(double* w, size_t n, double factor) {
+  size_t i = 0;
+  const __m256d f = _mm256_set1_pd(factor);
+  for(; i + 4 <= n; i += 4)
+    _mm256_storeu_pd(w + i, _mm256_mul_pd(_mm256_loadu_pd(w + i), f));
+  scale_weights_scalar(w + i, n - i, factor);
+}
+
+__attribute__((target("avx512f")))
+inline void scale_weights_avx512(double* w, size_t n, double factor) {
+  size_t i = 0;
+  const __m512d f = _mm512_set1_pd(factor);
+  for(; i + 8 <= n; i += 8)
+    _mm512_storeu_pd(w + i, _mm512_mul_pd(_mm512_loadu_pd(w + i), f));
+  scale_weights_scalar(w + i, n - i, factor);
+}
+
+__attribute__((target("avx2")))
+inline size_t select_below_avx2(const double* w, size_t n, double threshold, size_t* out) {
+  size_t i = 0, k = 0;
+  const __m256d limit = _mm256_set1_pd(threshold);
+  for(; i + 4 <= n; i += 4)
+    for(int m = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_loadu_pd(w + i), limit, _CMP_LT_OQ));
+        m; m &= m - 1)
+      out[k++] = i + __builtin_ctz(m);
+  for(size_t j = select_below_scalar(w + i, n - i, threshold, out + k); j--; )
+    out[k++] += i;
+  return k;
+}
+
+__attribute__((target("avx512f")))
+inline size_t select_below_avx512(const double* w, size_t n, double threshold, size_t* out) {
+  size_t i = 0, k = 0;
+  const __m512d limit = _mm512_set1_pd(threshold);
+  __m512i position = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m512i step = _mm512_set1_epi64(8);
+  for(; i + 8 <= n; i += 8) {
+    __mmask8 m = _mm512_cmp_pd_mask(_mm512_loadu_pd(w + i), limit, _CMP_LT_OQ);
+    _mm512_mask_compressstoreu_epi64(out + k, m, position);
+    k += __builtin_popcount(m);
+    position = _mm512_add_epi64(position, step);
+  }
+  for(size_t j = select_below_scalar(w + i, n - i, threshold, out + k); j--; )
+    out[k++] += i;
+  return k;
+}
+#pragma GCC diagnostic pop
+#endif
+
+///@brief Dispatching forms of the kernels above.
+template<typename Weight>
+  size_t relax_edges(const size_t* t, const Weight* w, size_t n, Weight base,
+      Weight* dist, size_t* improved) {
+    return relax_edges_scalar(t, w, n, base, dist, improved);
+  }
+
+template<typename Weight>
+  size_t min_weight(const Weight* w, size_t n) {return min_weight_scalar(w, n);}
+
+template<typename Weight>
+  void scale_weights(Weight* w, size_t n, Weight factor) {scale_weights_scalar(w, n, factor);}
+
+template<typename Weight>
+  size_t select_below(const Weight* w, size_t n, Weight threshold, size_t* out) {
+    return select_below_scalar(w, n, threshold, out);
+  }
+
+#if defined(__x86_64__) && defined(__GNUC__)
+inline size_t relax_edges(const size_t* t, const double* w, size_t n, double base,
+    double* dist, size_t* improved) {
+  switch(simd_kernel_level()) {
+    case simd_avx512: return relax_edges_avx512(t, w, n, base, dist, improved);
+    case simd_avx2: return relax_edges_avx2(t, w, n, base, dist, improved);
+    default: return relax_edges_scalar(t, w, n, base, dist, improved);
+  }
+}
+
+inline size_t min_weight(const double* w, size_t n) {
+  switch(simd_kernel_level()) {
+    case simd_avx512: return min_weight_avx512(w, n);
+    case simd_avx2: return min_weight_avx2(w, n);
+    default: return min_weight_scalar(w, n);
+  }
+}
+
+inline void scale_weights(double* w, size_t n, double factor) {
+  switch(simd_kernel_level()) {
+    case simd_avx512: return scale_weights_avx512(w, n, factor);
+    case simd_avx2: return scale_weights_avx2(w, n, factor);
+    default: return scale_weights_scalar(w, n, factor);
+  }
+}
+
+inline size_t select_below(const double* w, size_t n, double threshold, size_t* out) {
+  switch(simd_kernel_level()) {
+    case simd_avx512: return select_below_avx512(w, n, threshold, out);
+    case simd_avx2: return select_below_avx2(w, n, threshold, out);
+    default: return select_below_scalar(w, n, threshold, out);
+  }
+}
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// Out-edges of a graph in structure-of-arrays form: the targets of vertex v
+/// are targets()[offset(v), offset(v + 1)) and their weights the same range
+/// of weights(). Offsets are indexed by descriptor, holes included, so
+/// descriptor-indexed distance arrays line up with the targets directly.
+/// Unlike graph_csr the weights are mutable, and the arrays are plain
+/// vectors with no per-vertex properties or iterators around them.
+////////////////////////////////////////////////////////////////////////////////
+template<typename Weight>
+class edge_store {
+  public:
+    static const size_t npos = size_t(-1);
+
+    ///@brief Copy g's out-edges, in each vertex's adjacency order.
+    template<typename Graph>
+    explicit edge_store(const Graph& g) : m_offsets(vertex_descriptor_bound(g) + 1, 0) {
+      for(auto vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
+        m_vertices.push_back((*vi)->descriptor());
+        m_offsets[(*vi)->descriptor() + 1] = std::distance((*vi)->begin(), (*vi)->end());
+      }
+      for(size_t i = 1; i < m_offsets.size(); ++i)
+        m_offsets[i] += m_offsets[i - 1];
+      m_targets.resize(m_offsets.back());
+      m_weights.resize(m_offsets.back());
+      for(auto vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
+        size_t at = m_offsets[(*vi)->descriptor()];
+        for(auto aei = (*vi)->begin(); aei != (*vi)->end(); ++aei, ++at) {
+          m_targets[at] = (*aei)->target();
+          m_weights[at] = (*aei)->property();
+        }
+      }
+    }
+
+    ///@brief Accessors
+    size_t bound() const {return m_offsets.size() - 1;}
+    size_t num_vertices() const {return m_vertices.size();}
+    size_t num_edges() const {return m_targets.size();}
+    const std::vector<size_t>& vertices() const {return m_vertices;}
+    const std::vector<size_t>& targets() const {return m_targets;}
+    const std::vector<Weight>& weights() const {return m_weights;}
+    std::vector<Weight>& weights() {return m_weights;}
+    size_t offset(size_t v) const {return m_offsets[v];}
+    size_t degree(size_t v) const {return m_offsets[v + 1] - m_offsets[v];}
+
+    ///@brief relax_edges over v's out-edges with base dv.
+    size_t relax_out_edges(size_t v, Weight dv, Weight* dist, size_t* improved) const {
+      return relax_edges(m_targets.data() + offset(v), m_weights.data() + offset(v),
+          degree(v), dv, dist, improved);
+    }
+
+    ///@brief Position in targets()/weights() of v's lightest out-edge, npos
+    ///       if v has none.
+    size_t min_weight_out_edge(size_t v) const {
+      size_t i = min_weight(m_weights.data() + offset(v), degree(v));
+      return i == degree(v) ? npos : offset(v) + i;
+    }
+
+    ///@brief Multiply every weight by factor.
+    void scale(Weight factor) {scale_weights(m_weights.data(), m_weights.size(), factor);}
+
+    ///@brief Drop every edge whose weight is not below threshold, keeping
+    ///       the order of the rest.
+    void filter_below(Weight threshold) {
+      std::vector<size_t> kept(m_weights.size());
+      size_t k = select_below(m_weights.data(), m_weights.size(), threshold, kept.data());
+      // offsets follow the kept positions: each old offset becomes the
+      // number of kept positions before it
+      size_t j = 0;
+      for(size_t& o : m_offsets) {
+        size_t old = o;
+        while(j < k and kept[j] < old)
+          ++j;
+        o = j;
+      }
+      for(size_t i = 0; i < k; ++i) {
+        m_targets[i] = m_targets[kept[i]];
+        m_weights[i] = m_weights[kept[i]];
+      }
+      m_targets.resize(k);
+      m_weights.resize(k);
+    }
+
+  private:
+    std::vector<size_t> m_vertices;  //< Descriptors present, in g's order
+    std::vector<size_t> m_offsets;   //< Descriptor -> first out-edge (bound + 1)
+    std::vector<size_t> m_targets;   //< Out-edge targets grouped by source
+    std::vector<Weight> m_weights;   //< Out-edge weights, parallel to targets
+};
+
+///@brief Descriptor bound of the graph s was built from, so the property map
+///       helpers of graph_algorithms.h size their outputs for it.
+template<typename Weight>
+  size_t vertex_descriptor_bound(const edge_store<Weight>& s) {return s.bound();}
+
+
+///@brief dijkstra_shortest_paths over an edge_store, with the same results.
+///       Tentative distances are a descriptor-indexed array that each
+///       settled vertex's out-edges are relaxed against in one relax_edges
+///       call; the vertices it improves then get their heap entries. A
+///       settled vertex is never improved again, weights being non-negative.
+template<typename Weight, typename ParentMap, typename DistanceMap>
+  void dijkstra_shortest_paths(const edge_store<Weight>& s, size_t source,
+      ParentMap& p, DistanceMap& d) {
+    size_t bound = s.bound();
+    reset_property_map(p, s);
+    reset_property_map(d, s);
+    descriptor_bitmap present(bound);
+    for(size_t v : s.vertices()) {
+      present.set(v);
+      p[v] = -1;
+    }
+    if(source >= bound or !present.test(source))
+      return;
+
+    std::vector<size_t> parent(bound, size_t(-1)), improved;
+    std::vector<Weight> dist(bound, std::numeric_limits<Weight>::has_infinity
+        ? std::numeric_limits<Weight>::infinity() : std::numeric_limits<Weight>::max());
+    indexed_heap<Weight> heap(bound);
+    dist[source] = Weight();
+    heap.push(source, Weight());
+
+    while(!heap.empty()) {
+      size_t u = heap.top().second;
+      Weight du = heap.top().first;
+      heap.pop();
+      d[u] = du;
+      p[u] = parent[u];
+      GRAPH_STAT_ADD(vertices_visited, 1);
+      GRAPH_STAT_ADD(edges_examined, s.degree(u));
+
+      improved.resize(s.degree(u));
+      for(size_t i = 0, k = s.relax_out_edges(u, du, dist.data(), improved.data()); i < k; ++i) {
+        size_t t = improved[i];
+        if(heap.push_or_decrease(t, dist[t]))
+          parent[t] = u;
+      }
+    }
+  }
+
+
+#endif
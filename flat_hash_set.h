@@ -0,0 +1,441 @@
+#ifndef _FLAT_HASH_SET_H_
+#define _FLAT_HASH_SET_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "graph_stats.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// An open-addressing hash set in the style of Swiss tables. Elements live
+/// inline in one slot array next to an array of control bytes, one per slot:
+/// empty, deleted, or the low 7 bits of the element's hash (its fingerprint).
+/// A lookup hashes once, then scans the control bytes 16 at a time - a single
+/// SSE2 compare where available - and only inspects elements whose fingerprint
+/// matches, so a miss rarely touches an element at all. Groups are probed
+/// quadratically and the table grows at 7/8 load.
+///
+/// Hash and KeyEqual may also accept other key types (find(key), count(key),
+/// erase(key) take any K with hash(K) and equal(T, K)), so a set of pointers
+/// can be searched by descriptor without building a temporary element.
+///
+/// With InlineSlots > 0 the first elements live inside the set object itself
+/// and are found by a linear scan of their fingerprints; the table moves to
+/// the heap only when they overflow. Small sets, such as the adjacency of a
+/// low-degree vertex, then cost no allocation.
+///
+/// Iterators are invalidated by insertions that grow the table and, for the
+/// erased element only, by erase - as for std::unordered_set.
+////////////////////////////////////////////////////////////////////////////////
+template<typename T, typename Hash, typename KeyEqual, size_t InlineSlots = 0>
+class flat_hash_set {
+  static const size_t group_width = 16;
+  typedef int8_t ctrl_t;
+  static const ctrl_t empty_ctrl = -128;  //< 0b10000000
+  static const ctrl_t deleted_ctrl = -2;  //< 0b11111110
+
+  public:
+    typedef T value_type;
+    typedef T key_type;
+    typedef size_t size_type;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Forward iterator over the full slots. Elements are not mutable through
+    /// it, since that could change their hash.
+    ////////////////////////////////////////////////////////////////////////////
+    class const_iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T* pointer;
+        typedef const T& reference;
+
+        const_iterator() : m_ctrl(nullptr), m_slot(nullptr), m_end(nullptr) { }
+
+        reference operator*() const {return *m_slot;}
+        pointer operator->() const {return m_slot;}
+        const_iterator& operator++() {
+          ++m_ctrl;
+          ++m_slot;
+          skip_empty();
+          return *this;
+        }
+        const_iterator operator++(int) {
+          const_iterator i = *this;
+          ++*this;
+          return i;
+        }
+        bool operator==(const const_iterator& i) const {return m_ctrl == i.m_ctrl;}
+        bool operator!=(const const_iterator& i) const {return m_ctrl != i.m_ctrl;}
+
+      private:
+        const_iterator(const ctrl_t* c, T* s, const ctrl_t* e) :
+          m_ctrl(c), m_slot(s), m_end(e) { }
+
+        void skip_empty() {
+          while(m_ctrl != m_end and *m_ctrl < 0) {
+            ++m_ctrl;
+            ++m_slot;
+          }
+        }
+
+        const ctrl_t* m_ctrl; //< Control byte of the current slot
+        T* m_slot;            //< Current slot
+        const ctrl_t* m_end;  //< One past the last control byte
+
+        friend class flat_hash_set;
+    };
+    typedef const_iterator iterator;
+
+    ///@brief Constructors/destructor
+    flat_hash_set() {
+      reset();
+    }
+
+    flat_hash_set(const flat_hash_set& o) : flat_hash_set() {
+      reserve(o.size());
+      for(const T& x : o)
+        insert(x);
+    }
+
+    flat_hash_set(flat_hash_set&& o) : flat_hash_set() {
+      take(o);
+    }
+
+    flat_hash_set& operator=(flat_hash_set o) {
+      destroy_all();
+      release();
+      take(o);
+      return *this;
+    }
+
+    ~flat_hash_set() {
+      destroy_all();
+      release();
+    }
+
+    ///@brief Iterators
+    const_iterator begin() const {
+      const_iterator i(m_ctrl, m_slots, m_ctrl + m_capacity);
+      i.skip_empty();
+      return i;
+    }
+    const_iterator end() const {
+      return const_iterator(m_ctrl + m_capacity, m_slots + m_capacity, m_ctrl + m_capacity);
+    }
+    const_iterator cbegin() const {return begin();}
+    const_iterator cend() const {return end();}
+
+    ///@brief Capacity
+    size_t size() const {return m_size;}
+    bool empty() const {return m_size == 0;}
+    size_t capacity() const {return m_capacity;}
+    bool is_inline() const {return InlineSlots and m_ctrl == m_inline_ctrl;}
+
+    ///@brief Make room for n elements without growing again.
+    void reserve(size_t n) {
+      if(n > m_size + m_growth_left)
+        rehash(capacity_for(n));
+    }
+
+    ///@brief Lookup
+    template<typename K>
+    const_iterator find(const K& key) const {
+      size_t pos = locate(key, mix(m_hash(key)));
+      return pos == npos ? end() : at(pos);
+    }
+
+    template<typename K>
+    size_t count(const K& key) const {return locate(key, mix(m_hash(key))) != npos;}
+
+    ///@brief Modifiers. insert returns the element's position and whether it
+    ///       was added, as std::unordered_set does.
+    std::pair<const_iterator, bool> insert(const T& x) {
+      size_t h = mix(m_hash(x));
+      size_t pos = locate(x, h);
+      if(pos != npos)
+        return {at(pos), false};
+      if(m_growth_left == 0)
+        grow();
+      pos = free_slot(h);
+      m_growth_left -= m_ctrl[pos] == empty_ctrl;
+      set_ctrl(pos, fingerprint(h));
+      new(m_slots + pos) T(x);
+      ++m_size;
+      return {at(pos), true};
+    }
+
+    const_iterator erase(const_iterator i) {
+      size_t pos = i.m_ctrl - m_ctrl;
+      erase_at(pos);
+      ++i;
+      return i;
+    }
+
+    template<typename K>
+    size_t erase(const K& key) {
+      size_t pos = locate(key, mix(m_hash(key)));
+      if(pos == npos)
+        return 0;
+      erase_at(pos);
+      return 1;
+    }
+
+    ///@brief Remove every element, keeping the slot arrays.
+    void clear() {
+      destroy_all();
+      if(m_capacity)
+        std::memset(m_ctrl, empty_ctrl, m_capacity);
+      m_size = 0;
+      m_growth_left = is_inline() ? m_capacity : max_load(m_capacity);
+    }
+
+  private:
+    static const size_t npos = size_t(-1);
+
+    ///bitmask over the 16 control bytes of a group
+    struct group {
+      explicit group(const ctrl_t* c) {
+#ifdef __SSE2__
+        m_bytes = _mm_load_si128(reinterpret_cast<const __m128i*>(c));
+#else
+        std::memcpy(m_bytes, c, group_width);
+#endif
+      }
+
+      uint32_t match(ctrl_t c) const {
+#ifdef __SSE2__
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(c), m_bytes));
+#else
+        uint32_t m = 0;
+        for(size_t i = 0; i < group_width; ++i)
+          m |= uint32_t(m_bytes[i] == c) << i;
+        return m;
+#endif
+      }
+
+      uint32_t match_empty() const {return match(empty_ctrl);}
+
+      uint32_t match_empty_or_deleted() const {
+#ifdef __SSE2__
+        return _mm_movemask_epi8(m_bytes);
+#else
+        uint32_t m = 0;
+        for(size_t i = 0; i < group_width; ++i)
+          m |= uint32_t(m_bytes[i] < 0) << i;
+        return m;
+#endif
+      }
+
+#ifdef __SSE2__
+      __m128i m_bytes;
+#else
+      ctrl_t m_bytes[group_width];
+#endif
+    };
+
+    // Spread the user hash over all bits; identity hashes of small integers
+    // would otherwise collide in the group index.
+    static size_t mix(size_t h) {
+      uint64_t x = uint64_t(h) * 0x9E3779B97F4A7C15ull;
+      return size_t(x ^ (x >> 32));
+    }
+    static ctrl_t fingerprint(size_t h) {return ctrl_t(h & 0x7F);}
+    static size_t max_load(size_t capacity) {return capacity - capacity / 8;}
+    static unsigned lowest_bit(uint32_t m) {return __builtin_ctz(m);}
+
+    static size_t capacity_for(size_t n) {
+      size_t c = group_width;
+      while(max_load(c) < n)
+        c *= 2;
+      return c;
+    }
+
+    const_iterator at(size_t pos) const {
+      return const_iterator(m_ctrl + pos, m_slots + pos, m_ctrl + m_capacity);
+    }
+
+    // Slot holding an element equal to key, or npos.
+    template<typename K>
+    size_t locate(const K& key, size_t h) const {
+      GRAPH_STAT_ADD(hash_lookups, 1);
+      if(is_inline()) {
+        GRAPH_STAT_ADD(hash_probes, 1);
+        for(size_t pos = 0; pos < m_capacity; ++pos)
+          if(m_ctrl[pos] == fingerprint(h) and m_equal(m_slots[pos], key))
+            return pos;
+        return npos;
+      }
+      if(m_capacity == 0)
+        return npos;
+      const size_t groups_mask = m_capacity / group_width - 1;
+      const ctrl_t fp = fingerprint(h);
+      size_t g = (h >> 7) & groups_mask;
+      for(size_t step = 1;; ++step) {
+        GRAPH_STAT_ADD(hash_probes, 1);
+        group grp(m_ctrl + g * group_width);
+        for(uint32_t m = grp.match(fp); m; m &= m - 1) {
+          size_t pos = g * group_width + lowest_bit(m);
+          if(m_equal(m_slots[pos], key))
+            return pos;
+        }
+        if(grp.match_empty())
+          return npos;
+        g = (g + step) & groups_mask;
+      }
+    }
+
+    // First empty or deleted slot on the probe sequence of h.
+    size_t free_slot(size_t h) const {
+      if(is_inline())
+        return std::find_if(m_ctrl, m_ctrl + m_capacity, [](ctrl_t c) {return c < 0;}) - m_ctrl;
+      const size_t groups_mask = m_capacity / group_width - 1;
+      size_t g = (h >> 7) & groups_mask;
+      for(size_t step = 1;; ++step) {
+        uint32_t m = group(m_ctrl + g * group_width).match_empty_or_deleted();
+        if(m)
+          return g * group_width + lowest_bit(m);
+        g = (g + step) & groups_mask;
+      }
+    }
+
+    void set_ctrl(size_t pos, ctrl_t c) {m_ctrl[pos] = c;}
+
+    // A slot may go straight back to empty if its group still has an empty
+    // slot, since no probe can then have passed through the group.
+    void erase_at(size_t pos) {
+      m_slots[pos].~T();
+      --m_size;
+      if(is_inline()) {
+        set_ctrl(pos, empty_ctrl);
+        ++m_growth_left;
+        return;
+      }
+      group grp(m_ctrl + pos / group_width * group_width);
+      if(grp.match_empty()) {
+        set_ctrl(pos, empty_ctrl);
+        ++m_growth_left;
+      }
+      else
+        set_ctrl(pos, deleted_ctrl);
+    }
+
+    // Out of fresh slots: double, or rebuild in place if tombstones take up
+    // much of the table.
+    void grow() {
+      if(is_inline())
+        rehash(capacity_for(m_size + 1));
+      else if(m_capacity and m_size <= max_load(m_capacity) / 2)
+        rehash(m_capacity);
+      else
+        rehash(m_capacity ? m_capacity * 2 : group_width);
+    }
+
+    void rehash(size_t capacity) {
+      ctrl_t* old_ctrl = m_ctrl;
+      T* old_slots = m_slots;
+      size_t old_capacity = m_capacity;
+
+      GRAPH_STAT_ADD(rehashes, 1);
+      GRAPH_STAT_ADD(allocations, 1);
+      void* block = ::operator new(capacity * (1 + sizeof(T)));
+      m_ctrl = static_cast<ctrl_t*>(block);
+      m_slots = reinterpret_cast<T*>(m_ctrl + capacity);
+      std::memset(m_ctrl, empty_ctrl, capacity);
+      m_capacity = capacity;
+      m_growth_left = max_load(capacity) - m_size;
+
+      for(size_t i = 0; i < old_capacity; ++i)
+        if(old_ctrl[i] >= 0) {
+          size_t h = mix(m_hash(old_slots[i]));
+          size_t pos = free_slot(h);
+          set_ctrl(pos, fingerprint(h));
+          new(m_slots + pos) T(std::move(old_slots[i]));
+          old_slots[i].~T();
+        }
+      if(old_ctrl != m_inline_ctrl)
+        ::operator delete(old_ctrl);
+    }
+
+    // Empty set on the inline slots, or on no storage at all.
+    void reset() {
+      m_size = 0;
+      if(InlineSlots) {
+        m_ctrl = m_inline_ctrl;
+        m_slots = reinterpret_cast<T*>(&m_inline_slots);
+        m_capacity = m_growth_left = InlineSlots;
+        std::memset(m_ctrl, empty_ctrl, InlineSlots);
+      }
+      else {
+        m_ctrl = nullptr;
+        m_slots = nullptr;
+        m_capacity = m_growth_left = 0;
+      }
+    }
+
+    // Free a heap table, whose elements must already be gone, and reset.
+    void release() {
+      if(!is_inline())
+        ::operator delete(m_ctrl);
+      reset();
+    }
+
+    // Take over o's heap table, or copy out its inline elements, leaving o
+    // empty; this must be empty and reset.
+    void take(flat_hash_set& o) {
+      if(o.is_inline() or o.m_capacity == 0) {
+        for(const T& x : o)
+          insert(x);
+        o.clear();
+        return;
+      }
+      release();
+      m_ctrl = o.m_ctrl;
+      m_slots = o.m_slots;
+      m_capacity = o.m_capacity;
+      m_size = o.m_size;
+      m_growth_left = o.m_growth_left;
+      o.reset();
+    }
+
+    void destroy_all() {
+      for(size_t i = 0; i < m_capacity; ++i)
+        if(m_ctrl[i] >= 0)
+          m_slots[i].~T();
+    }
+
+    ctrl_t* m_ctrl;        //< Control bytes, one per slot; the block also holds the slots
+    T* m_slots;            //< Element storage, after the control bytes
+    size_t m_capacity;     //< Slots, a power of two and multiple of group_width
+    size_t m_size;         //< Full slots
+    size_t m_growth_left;  //< Empty slots usable before the 7/8 load limit
+    Hash m_hash;           //< Hash, applied before mix()
+    KeyEqual m_equal;      //< Element/key equality
+    ctrl_t m_inline_ctrl[InlineSlots ? InlineSlots : 1]; //< Control bytes of the inline slots
+    typename std::aligned_storage<sizeof(T) * (InlineSlots ? InlineSlots : 1),
+             alignof(T)>::type m_inline_slots;            //< Inline slots
+};
+
+template<typename T, typename Hash, typename KeyEqual, size_t InlineSlots>
+  const size_t flat_hash_set<T, Hash, KeyEqual, InlineSlots>::group_width;
+template<typename T, typename Hash, typename KeyEqual, size_t InlineSlots>
+  const int8_t flat_hash_set<T, Hash, KeyEqual, InlineSlots>::empty_ctrl;
+template<typename T, typename Hash, typename KeyEqual, size_t InlineSlots>
+  const int8_t flat_hash_set<T, Hash, KeyEqual, InlineSlots>::deleted_ctrl;
+template<typename T, typename Hash, typename KeyEqual, size_t InlineSlots>
+  const size_t flat_hash_set<T, Hash, KeyEqual, InlineSlots>::npos;
+
+
+#endif
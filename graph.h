@@ -6,17 +6,23 @@
 #include <utility>
 #include <algorithm>
 #include <memory>
+#include <tuple>
+#include <type_traits>
 #include <unordered_set>
+#include <vector>
 
-#include <boost/functional/hash.hpp>
+#include "flat_hash_set.h"
+#include "node_pool.h"
 
 
 
 ////////////////////////////////////////////////////////////////////////////////
 /// A generic adjacency-list graph where each vertex stores a VertexProperty and
-/// each edge stores an EdgeProperty.
+/// each edge stores an EdgeProperty. The first InlineEdges edges of each
+/// adjacency list are stored inside the vertex, so low-degree vertices need
+/// no adjacency allocation; longer lists spill to a heap table.
 ////////////////////////////////////////////////////////////////////////////////
-template<typename VertexProperty, typename EdgeProperty>
+template<typename VertexProperty, typename EdgeProperty, size_t InlineEdges = 4>
 class graph {
 
   // The vertex and edge classes are forward-declared to allow their use in the
@@ -41,17 +47,22 @@ class graph {
     /// Unique edge identifier represents pair of vertex descriptors
     typedef std::pair<size_t, size_t> edge_descriptor;
 
+    /// Source, target and property of an edge, as taken by insert_edges
+    typedef std::tuple<size_t, size_t, EdgeProperty> edge_triple;
+
     ///@brief A container for the vertices. It should contain "vertex*" or
-    ///      shared_ptr<vertex>.
-    typedef std::unordered_set<vertex*, vertex_hash, vertex_eq> MyVertexContainer;
+    ///      shared_ptr<vertex>. Flat open-addressing sets (flat_hash_set.h)
+    ///      are searched by descriptor directly.
+    typedef flat_hash_set<vertex*, vertex_hash, vertex_eq> MyVertexContainer;
 
     ///@brief A container for the edges. It should contain "edge*" or
     ///      shared_ptr<edge>.
-    typedef std::unordered_set<edge*, edge_hash, edge_eq> MyEdgeContainer;
+    typedef flat_hash_set<edge*, edge_hash, edge_eq> MyEdgeContainer;
 
     ///@brief A container for the adjacency lists. It should contain
-    ///      "edge*" or shared_ptr<edge>.
-    typedef std::unordered_set<edge*, edge_hash, edge_eq> MyAdjEdgeContainer;
+    ///      "edge*" or shared_ptr<edge>. The first InlineEdges live in the
+    ///      vertex itself.
+    typedef flat_hash_set<edge*, edge_hash, edge_eq, InlineEdges> MyAdjEdgeContainer;
 	
 	  ///@brief A container for adjacency matrix. It should contain 
 	  ///       "edge*" or shared_ptr<edge>. 
@@ -71,8 +82,12 @@ class graph {
 
     // Required graph operations
 
-    ///@brief Constructor/destructor
-    graph() : m_max_vd(0) { }
+    ///@brief Constructor/destructor. With track_in_edges every vertex also
+    ///       keeps its in-edges, which makes erase_vertex O(degree) and
+    ///       enables in_edges_begin/end; without it erase_vertex scans all
+    ///       edges and the in-edge ranges stay empty.
+    explicit graph(bool track_in_edges = true) :
+      m_max_vd(0), m_track_in_edges(track_in_edges) { }
 
     ~graph() {
       clear();
@@ -96,43 +111,44 @@ class graph {
     ///@brief Define accessors
     size_t num_vertices() const {return m_vertices.size();}
     size_t num_edges() const {return m_edges.size();}
+    bool tracks_in_edges() const {return m_track_in_edges;}
 
     vertex_iterator find_vertex(vertex_descriptor vd) {
-      vertex v(vd, VertexProperty());
-      return m_vertices.find(&v);
+      return m_vertices.find(vd);
     }
 
     const_vertex_iterator find_vertex(vertex_descriptor vd) const {
-      vertex v(vd, VertexProperty());
-      return m_vertices.find(&v);
+      return m_vertices.find(vd);
     }
 
     edge_iterator find_edge(edge_descriptor ed) {
-      edge e(ed.first, ed.second, EdgeProperty());
-      return m_edges.find(&e);
+      return m_edges.find(ed);
     }
 
     const_edge_iterator find_edge(edge_descriptor ed) const {
-      edge e(ed.first, ed.second, EdgeProperty());
-      return m_edges.find(&e);
+      return m_edges.find(ed);
     }
 
     ///@todo Define modifiers
     vertex_descriptor insert_vertex(const VertexProperty& vp){
-      vertex* v = new vertex(m_max_vd, vp);
-      ++m_max_vd;
+      vertex* v = m_vertex_pool.create(m_max_vd, vp);
       m_vertices.insert(v);
-	    return m_max_vd;
+	    return m_max_vd++;
 	  }
 
     edge_descriptor insert_edge(vertex_descriptor sd, vertex_descriptor td, const EdgeProperty& ep){
-      edge* e = new edge(sd, td, ep);
       vertex_iterator si = find_vertex(sd);
       vertex_iterator ti = find_vertex(td);
       if (si == vertices_end() or ti == vertices_end())
         return std::make_pair(sd, td); 
-      m_edges.insert(e);
+      edge* e = m_edge_pool.create(sd, td, ep);
+      if (!m_edges.insert(e).second) {
+        m_edge_pool.destroy(e);
+        return std::make_pair(sd, td);
+      }
       (*si)->m_out_edges.insert(e);
+      if (m_track_in_edges)
+        (*ti)->m_in_edges.insert(e);
 		  return std::make_pair(sd, td);	
 	  }
 
@@ -145,52 +161,232 @@ class graph {
     void erase_vertex(vertex_descriptor vd){  
       std::vector<edge_descriptor> edges_to_erase;
       vertex_iterator vi = find_vertex(vd);
-      vertex* v = *vi;
       if (vi == vertices_end())
         return;
-      for (vertex_iterator v = vertices_begin(); v != vertices_end(); ++v) {
-        for (adj_edge_iterator e = (*v)->begin(); e != (*v)->end(); ++e) {
-          if ((*e)->target() == vd or (*e)->source() == vd)
-            edges_to_erase.push_back((*e)->descriptor());
+      vertex* v = *vi;
+      if (m_track_in_edges) {
+        for (adj_edge_iterator e = v->begin(); e != v->end(); ++e)
+          edges_to_erase.push_back((*e)->descriptor());
+        for (adj_edge_iterator e = v->in_edges_begin(); e != v->in_edges_end(); ++e)
+          edges_to_erase.push_back((*e)->descriptor());
+      }
+      else {
+        for (vertex_iterator v = vertices_begin(); v != vertices_end(); ++v) {
+          for (adj_edge_iterator e = (*v)->begin(); e != (*v)->end(); ++e) {
+            if ((*e)->target() == vd or (*e)->source() == vd)
+              edges_to_erase.push_back((*e)->descriptor());
+          }
         }
       }
       for (const auto& ed: edges_to_erase)
         erase_edge(ed);
-      m_vertices.erase(*vi);
-      delete v;
+      m_vertices.erase(vi);
+      m_vertex_pool.destroy(v);
 	  }
 
     void erase_edge(edge_descriptor ed){
       edge_iterator ei = find_edge(ed);
-      edge* e = *ei;
       if (ei == edges_end())
         return;
+      edge* e = *ei;
 
-      vertex_iterator v = find_vertex((*ei)->source());
-      m_edges.erase(e);
+      vertex_iterator v = find_vertex(e->source());
+      m_edges.erase(ei);
       (*v)->m_out_edges.erase(e);
-      delete e;
+      if (m_track_in_edges)
+        (*find_vertex(e->target()))->m_in_edges.erase(e);
+      m_edge_pool.destroy(e);
 	  }
 	////end of @todo
+
+    ///@brief Batch modifiers. insert_vertices adds one vertex per property in
+    ///       [first, last) and returns the descriptor of the first; the rest
+    ///       follow consecutively. insert_edges takes a forward range of
+    ///       (source, target, property) tuples such as edge_triple and
+    ///       returns how many edges were added; insert_edges_undirected adds
+    ///       both directions of each. Every endpoint of the batch is looked up
+    ///       once, all containers are sized once from the batch's degree
+    ///       counts, and edges are linked grouped by source. Edges with a
+    ///       missing endpoint, or already present, are skipped as in
+    ///       insert_edge. erase_edges removes the edges named by a range of
+    ///       descriptors and returns how many existed.
+    template<typename ForwardIterator>
+    vertex_descriptor insert_vertices(ForwardIterator first, ForwardIterator last) {
+      vertex_descriptor vd = m_max_vd;
+      reserve(std::distance(first, last), 0);
+      for(; first != last; ++first)
+        insert_vertex(*first);
+      return vd;
+    }
+
+    template<typename ForwardIterator>
+    size_t insert_edges(ForwardIterator first, ForwardIterator last) {
+      return insert_edge_batch(first, last, false);
+    }
+
+    template<typename ForwardIterator>
+    size_t insert_edges_undirected(ForwardIterator first, ForwardIterator last) {
+      return insert_edge_batch(first, last, true);
+    }
+
+    template<typename InputIterator>
+    size_t erase_edges(InputIterator first, InputIterator last) {
+      std::vector<edge*> doomed;
+      for(; first != last; ++first) {
+        edge_iterator ei = find_edge(*first);
+        if (ei != edges_end())
+          doomed.push_back(*ei);
+      }
+      std::sort(doomed.begin(), doomed.end(), edge_comp());
+      doomed.erase(std::unique(doomed.begin(), doomed.end()), doomed.end());
+
+      //one vertex lookup per run of equal sources, then of equal targets
+      vertex* v = nullptr;
+      for (size_t i = 0; i < doomed.size(); ++i) {
+        if (i == 0 or doomed[i]->source() != doomed[i - 1]->source())
+          v = *find_vertex(doomed[i]->source());
+        v->m_out_edges.erase(doomed[i]);
+        m_edges.erase(doomed[i]);
+      }
+      if (m_track_in_edges) {
+        std::sort(doomed.begin(), doomed.end(), [](edge* e, edge* f) {
+            return e->target() < f->target();
+            });
+        for (size_t i = 0; i < doomed.size(); ++i) {
+          if (i == 0 or doomed[i]->target() != doomed[i - 1]->target())
+            v = *find_vertex(doomed[i]->target());
+          v->m_in_edges.erase(doomed[i]);
+        }
+      }
+      for (edge* e : doomed)
+        m_edge_pool.destroy(e);
+      return doomed.size();
+    }
 	
+    ///@brief Destroy every vertex and edge and hand the node blocks back to
+    ///       the heap. Nodes with trivial destructors are not visited.
     void clear() {
       m_max_vd = 0;
-      for(auto v : m_vertices)
-        delete v;
+      if(!std::is_trivially_destructible<vertex>::value)
+        for(auto v : m_vertices)
+          v->~vertex();
       m_vertices.clear();
-      for(auto e : m_edges)
-        delete e;
+      if(!std::is_trivially_destructible<edge>::value)
+        for(auto e : m_edges)
+          e->~edge();
       m_edges.clear();
+      m_vertex_pool.release();
+      m_edge_pool.release();
+    }
+
+    ///@brief Size every container for a bulk build of num_vertices more
+    ///       vertices and num_edges more edges.
+    void reserve(size_t num_vertices, size_t num_edges) {
+      m_vertices.reserve(m_vertices.size() + num_vertices);
+      m_edges.reserve(m_edges.size() + num_edges);
+      m_vertex_pool.reserve(num_vertices);
+      m_edge_pool.reserve(num_edges);
+    }
+
+    ///@brief Size the adjacency containers of vd for out_degree more out-edges
+    ///       and in_degree more in-edges.
+    void reserve_adjacency(vertex_descriptor vd, size_t out_degree, size_t in_degree) {
+      vertex_iterator vi = find_vertex(vd);
+      if (vi == vertices_end())
+        return;
+      (*vi)->m_out_edges.reserve((*vi)->m_out_edges.size() + out_degree);
+      if (m_track_in_edges)
+        (*vi)->m_in_edges.reserve((*vi)->m_in_edges.size() + in_degree);
+    }
+
+    ///@brief Allocation report: heap blocks requested by the node pools and
+    ///       nodes they handed out (the allocations plain new would make).
+    size_t block_allocations() const {
+      return m_vertex_pool.block_allocations() + m_edge_pool.block_allocations();
+    }
+    size_t node_allocations() const {
+      return m_vertex_pool.node_allocations() + m_edge_pool.node_allocations();
     }
 
     // Friend declarations for input/output.
-    template<typename V, typename E>
-    friend std::istream& operator>>(std::istream&, graph<V, E>&);
-    template<typename V, typename E>
-    friend std::ostream& operator<<(std::ostream&, const graph<V, E>&);
+    template<typename V, typename E, size_t N>
+    friend std::istream& operator>>(std::istream&, graph<V, E, N>&);
+    template<typename V, typename E, size_t N>
+    friend std::ostream& operator<<(std::ostream&, const graph<V, E, N>&);
 
   private:
+    // Shared body of insert_edges and insert_edges_undirected.
+    template<typename ForwardIterator>
+    size_t insert_edge_batch(ForwardIterator first, ForwardIterator last, bool undirected) {
+      struct pending {
+        size_t source, target; //< Positions in ends
+        ForwardIterator record; //< Where the property lives
+      };
+
+      //validate every endpoint of the batch once
+      std::vector<vertex_descriptor> ends;
+      for (ForwardIterator r = first; r != last; ++r) {
+        ends.push_back(std::get<0>(*r));
+        ends.push_back(std::get<1>(*r));
+      }
+      std::sort(ends.begin(), ends.end());
+      ends.erase(std::unique(ends.begin(), ends.end()), ends.end());
+      std::vector<vertex*> verts(ends.size(), nullptr);
+      for (size_t i = 0; i < ends.size(); ++i) {
+        vertex_iterator vi = find_vertex(ends[i]);
+        if (vi != vertices_end())
+          verts[i] = *vi;
+      }
+      auto position = [&](vertex_descriptor vd) {
+        return size_t(std::lower_bound(ends.begin(), ends.end(), vd) - ends.begin());
+      };
+
+      //group by source, counting degrees on the way
+      std::vector<pending> batch;
+      std::vector<size_t> out_degree(ends.size(), 0), in_degree(ends.size(), 0);
+      for (ForwardIterator r = first; r != last; ++r) {
+        size_t s = position(std::get<0>(*r)), t = position(std::get<1>(*r));
+        if (!verts[s] or !verts[t])
+          continue;
+        batch.push_back({s, t, r});
+        ++out_degree[s];
+        ++in_degree[t];
+        if (undirected) {
+          batch.push_back({t, s, r});
+          ++out_degree[t];
+          ++in_degree[s];
+        }
+      }
+      std::stable_sort(batch.begin(), batch.end(), [](const pending& a, const pending& b) {
+          return a.source < b.source;
+          });
+
+      //size every container once, then link
+      m_edges.reserve(m_edges.size() + batch.size());
+      m_edge_pool.reserve(batch.size());
+      for (size_t i = 0; i < ends.size(); ++i) {
+        if (out_degree[i])
+          verts[i]->m_out_edges.reserve(verts[i]->m_out_edges.size() + out_degree[i]);
+        if (m_track_in_edges and in_degree[i])
+          verts[i]->m_in_edges.reserve(verts[i]->m_in_edges.size() + in_degree[i]);
+      }
+      size_t inserted = 0;
+      for (const pending& p : batch) {
+        edge* e = m_edge_pool.create(ends[p.source], ends[p.target], std::get<2>(*p.record));
+        if (!m_edges.insert(e).second) {
+          m_edge_pool.destroy(e);
+          continue;
+        }
+        verts[p.source]->m_out_edges.insert(e);
+        if (m_track_in_edges)
+          verts[p.target]->m_in_edges.insert(e);
+        ++inserted;
+      }
+      return inserted;
+    }
+
 	  size_t m_max_vd; //< Maximum vertex descriptor assigned
+    bool m_track_in_edges; //<Whether vertices keep their in-edges
     MyVertexContainer m_vertices; //<Contains all vertices
     MyEdgeContainer m_edges;    //<Contains all edges
     // Required internal classes
@@ -209,6 +405,12 @@ class graph {
         adj_edge_iterator end() {return m_out_edges.end();}
         const_adj_edge_iterator cend() const {return m_out_edges.cend();}
 
+        // in-edge iterators, empty unless the graph tracks in-edges
+        adj_edge_iterator in_edges_begin() {return m_in_edges.begin();}
+        const_adj_edge_iterator in_edges_cbegin() const {return m_in_edges.cbegin();}
+        adj_edge_iterator in_edges_end() {return m_in_edges.end();}
+        const_adj_edge_iterator in_edges_cend() const {return m_in_edges.cend();}
+
         //accessors
         const vertex_descriptor descriptor() const {return m_descriptor;}
         VertexProperty& property() {return m_property;}
@@ -219,6 +421,7 @@ class graph {
         vertex_descriptor m_descriptor; // Unique id for the vertex - assigned during insertion
         VertexProperty m_property;      // Label or property of the vertex - passed during insertion
         MyAdjEdgeContainer m_out_edges; // Container that includes the out edges
+        MyAdjEdgeContainer m_in_edges;  // Container that includes the in edges, if tracked
 
         friend class graph;
     };
@@ -247,33 +450,40 @@ class graph {
         vertex_descriptor m_target; // Unique id of the target vertex 
         EdgeProperty m_property;    // Label or weight of the edge 
     };
+
+    node_pool<vertex> m_vertex_pool; //<Storage for all vertices
+    node_pool<edge> m_edge_pool;     //<Storage for all edges
 	
-	  struct vertex_hash {
-      size_t operator()(vertex* const& v) const {
-        return h(v->descriptor());
-      }
-      std::hash<vertex_descriptor> h;
+    // Hashes and equalities accept an element or a descriptor, so the
+    // containers can be searched by descriptor.
+    struct vertex_hash {
+      size_t operator()(vertex* const& v) const {return (*this)(v->descriptor());}
+      size_t operator()(vertex_descriptor vd) const {return vd;}
     };
 
     struct edge_hash {
-	  // You can re-write this function to create the hash-value for a pair i.e., edge descriptor
-	  // instead of using boost::hash
-      size_t operator()(edge* const& e) const {
-        return h(e->descriptor());
-	  }
-      boost::hash<edge_descriptor> h;
+      size_t operator()(edge* const& e) const {return (*this)(e->descriptor());}
+      size_t operator()(const edge_descriptor& ed) const {
+        return ed.first * 0x9E3779B97F4A7C15ull ^ ed.second;
+      }
     };
 
     struct vertex_eq {
       bool operator()(vertex* const& u, vertex* const& v) const {
         return u->descriptor() == v->descriptor();
       }
+      bool operator()(vertex* const& u, vertex_descriptor vd) const {
+        return u->descriptor() == vd;
+      }
     };
 
     struct edge_eq {
       bool operator()(edge* const& e, edge* const& f) const {
         return e->descriptor() == f->descriptor();
       }
+      bool operator()(edge* const& e, const edge_descriptor& ed) const {
+        return e->source() == ed.first and e->target() == ed.second;
+      }
     };
 	
 	  struct edge_comp {
@@ -284,12 +494,11 @@ class graph {
 };
 
 ///@brief Define io operations for the graph.
-template<typename V, typename E>
-std::istream& operator>>(std::istream& is, graph<V, E>& g) {
+template<typename V, typename E, size_t N>
+std::istream& operator>>(std::istream& is, graph<V, E, N>& g) {
   size_t num_verts, num_edges;
   is >> num_verts >> num_edges;
-  g.m_vertices.reserve(num_verts);
-  g.m_vertices.reserve(num_edges);
+  g.reserve(num_verts, num_edges);
   for(size_t i = 0; i < num_verts; ++i) {
     V v;
     is >> v;
@@ -304,8 +513,8 @@ std::istream& operator>>(std::istream& is, graph<V, E>& g) {
   return is;
 }
 
-template<typename V, typename E>
-std::ostream& operator<<(std::ostream& os, const graph<V, E>& g) {
+template<typename V, typename E, size_t N>
+std::ostream& operator<<(std::ostream& os, const graph<V, E, N>& g) {
   os << g.num_vertices() << " " << g.num_edges() << std::endl;
   for(auto i = g.vertices_cbegin(); i != g.vertices_cend(); ++i)
     os << (*i)->property() << std::endl;
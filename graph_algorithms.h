@@ -1,10 +1,15 @@
 #ifndef _GRAPH_ALGORITHMS_H_
 #define _GRAPH_ALGORITHMS_H_
 
-#include <queue>
-#include <stack>
-#include <unordered_set>
-#include <boost/functional/hash.hpp> // Comment this if you haven't boost installed
+#include <algorithm>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <vector>
+
+#include "graph_stats.h"
+#include "indexed_heap.h"
+#include "property_map.h"
 
 
 // This is an example list of the basic algorithms we will work with in class.
@@ -15,7 +20,8 @@
 //
 //  - ParentMap: associative container between vertex_descriptors and parent
 //               vertex_descriptors. This is a representation of the free
-//               trees/forests created by these search methods.
+//               trees/forests created by these search methods. Either a
+//               std::unordered_map or a vector_property_map (property_map.h).
 //
 //  - DistanceMap: associative container between vertex_descriptors and
 //                 EdgeProperties. This represents the summation of the path
@@ -26,108 +32,671 @@
 //
 
 
+///@brief Fixed-size bitmap indexed by vertex descriptor.
+class descriptor_bitmap {
+  public:
+    explicit descriptor_bitmap(size_t n = 0) : m_words((n + 63) / 64, 0) { }
+
+    bool test(size_t i) const {return (m_words[i >> 6] >> (i & 63)) & 1;}
+    void set(size_t i) {m_words[i >> 6] |= uint64_t(1) << (i & 63);}
+    void reset() {std::fill(m_words.begin(), m_words.end(), 0);}
+    void swap(descriptor_bitmap& o) {m_words.swap(o.m_words);}
+
+  private:
+    std::vector<uint64_t> m_words;
+};
+
+
+///@brief One past the largest vertex descriptor in g, i.e. the size of a
+///       table indexed by descriptor.
+template<typename Graph>
+  size_t vertex_descriptor_bound(const Graph& g) {
+    size_t bound = 0;
+    for(auto vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi)
+      bound = std::max(bound, size_t((*vi)->descriptor()) + 1);
+    return bound;
+  }
+
+
+///@brief Empty an output property map before an algorithm fills it. A
+///       vector_property_map is also sized to g's descriptors up front.
+template<typename PropertyMap, typename Graph>
+  void reset_property_map(PropertyMap& m, const Graph&) {
+    m.clear();
+  }
+
+template<typename Key, typename T, typename Graph>
+  void reset_property_map(vector_property_map<Key, T>& m, const Graph& g) {
+    m.clear();
+    m.reserve(vertex_descriptor_bound(g));
+  }
+
+
+///@brief Base class for search visitors. A visitor passed to
+///       breadth_first_visit or depth_first_visit has its hooks called as the
+///       search runs; a derived visitor hides the hooks it needs and inherits
+///       empty ones for the rest. Hooks are resolved at compile time, so the
+///       empty ones inline away. The search ends as soon as stop() returns
+///       true; it is polled after every hook.
+///
+///       start_vertex(vd, g)     vd roots a new search tree
+///       discover_vertex(vd, g)  vd is reached for the first time
+///       examine_edge(e, g)      out-edge e of the vertex being expanded
+///       tree_edge(e, g)         e discovered its target
+///       non_tree_edge(e, g)     e led to an already discovered vertex
+///       finish_vertex(vd, g)    all out-edges of vd have been examined
+///
+///       Edges are passed as the graph's adjacency element (e->source(),
+///       e->target(), e->property()).
+struct search_visitor {
+  template<typename Graph>
+    void start_vertex(typename Graph::vertex_descriptor, const Graph&) { }
+  template<typename Graph>
+    void discover_vertex(typename Graph::vertex_descriptor, const Graph&) { }
+  template<typename Edge, typename Graph>
+    void examine_edge(const Edge&, const Graph&) { }
+  template<typename Edge, typename Graph>
+    void tree_edge(const Edge&, const Graph&) { }
+  template<typename Edge, typename Graph>
+    void non_tree_edge(const Edge&, const Graph&) { }
+  template<typename Graph>
+    void finish_vertex(typename Graph::vertex_descriptor, const Graph&) { }
+  bool stop() const {return false;}
+};
+
+
+///@brief Visitor that records the search forest in a ParentMap, roots
+///       mapping to -1. It is what breadth_first_search and
+///       depth_first_search run.
+template<typename ParentMap>
+struct parent_recorder : search_visitor {
+  explicit parent_recorder(ParentMap& p) : m_parents(p) { }
+
+  template<typename Graph>
+    void start_vertex(typename Graph::vertex_descriptor vd, const Graph&) {
+      m_parents[vd] = -1;
+    }
+  template<typename Edge, typename Graph>
+    void tree_edge(const Edge& e, const Graph&) {
+      m_parents[e->target()] = e->source();
+    }
+
+  ParentMap& m_parents; //< Output
+};
+
+
+///@brief Visited set of a search rooted at one vertex: a bitmap indexed by
+///       descriptor that grows to the largest descriptor set, so nothing is
+///       allocated for the part of the graph the search never reaches.
+template<typename VertexDescriptor>
+class descriptor_set {
+  public:
+    bool test(VertexDescriptor vd) const {
+      size_t i = vd;
+      return (i >> 6) < m_words.size() and ((m_words[i >> 6] >> (i & 63)) & 1);
+    }
+    void set(VertexDescriptor vd) {
+      size_t i = vd;
+      if((i >> 6) >= m_words.size())
+        m_words.resize(std::max((i >> 6) + 1, 2 * m_words.size()), 0);
+      m_words[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+
+  private:
+    std::vector<uint64_t> m_words;
+};
+
+
+///@brief Search the component of root not yet in visited, first-in-first-out
+///       (breadth-first) or last-in-first-out. A vertex is marked when it is
+///       discovered, so each is queued once. work is scratch space.
+///@return False if the visitor stopped the search.
+template<bool LastInFirstOut, typename Graph, typename Visitor, typename VisitedSet>
+  bool search_component(const Graph& g, typename Graph::vertex_descriptor root,
+      Visitor& vis, VisitedSet& visited,
+      std::vector<typename Graph::vertex_descriptor>& work) {
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    typedef typename Graph::const_adj_edge_iterator adj_edge_iterator;
+
+    visited.set(root);
+    vis.start_vertex(root, g);
+    if(vis.stop())
+      return false;
+    vis.discover_vertex(root, g);
+    if(vis.stop())
+      return false;
+    work.assign(1, root);
+    size_t head = 0;
+    while(head < work.size()) {
+      vertex_descriptor vd;
+      if(LastInFirstOut) {
+        vd = work.back();
+        work.pop_back();
+      }
+      else
+        vd = work[head++];
+      GRAPH_STAT_ADD(vertices_visited, 1);
+      auto& v = *g.find_vertex(vd);
+      for(adj_edge_iterator aei = v->begin(); aei != v->end(); ++aei) {
+        GRAPH_STAT_ADD(edges_examined, 1);
+        vis.examine_edge(*aei, g);
+        if(vis.stop())
+          return false;
+        vertex_descriptor t = (*aei)->target();
+        if(!visited.test(t)) {
+          //discovery edge
+          visited.set(t);
+          vis.tree_edge(*aei, g);
+          if(vis.stop())
+            return false;
+          vis.discover_vertex(t, g);
+          work.push_back(t);
+        }
+        else
+          vis.non_tree_edge(*aei, g);
+        if(vis.stop())
+          return false;
+      }
+      vis.finish_vertex(vd, g);
+      if(vis.stop())
+        return false;
+    }
+    return true;
+  }
+
+
+///@brief Breadth-first search of the whole graph, one tree per component in
+///       vertex order, reporting to vis.
+template<typename Graph, typename Visitor>
+  void breadth_first_visit(const Graph& g, Visitor& vis) {
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    descriptor_bitmap visited(vertex_descriptor_bound(g));
+    std::vector<vertex_descriptor> work;
+    //for each CC
+    for(auto vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi)
+      if(!visited.test((*vi)->descriptor()) and
+          !search_component<false>(g, (*vi)->descriptor(), vis, visited, work))
+        return;
+  }
+
+///@brief Breadth-first search from source only, reporting to vis. Its cost
+///       follows the part of the graph explored, so a visitor that stops at a
+///       target answers a point-to-point query without touching the rest.
+template<typename Graph, typename Visitor>
+  void breadth_first_visit(const Graph& g, typename Graph::vertex_descriptor source,
+      Visitor& vis) {
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    if(g.find_vertex(source) == g.vertices_cend())
+      return;
+    descriptor_set<vertex_descriptor> visited;
+    std::vector<vertex_descriptor> work;
+    search_component<false>(g, source, vis, visited, work);
+  }
+
+///@brief Depth-first counterparts of breadth_first_visit. Vertices are
+///       discovered when first seen and expanded last-seen-first.
+template<typename Graph, typename Visitor>
+  void depth_first_visit(const Graph& g, Visitor& vis) {
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    descriptor_bitmap visited(vertex_descriptor_bound(g));
+    std::vector<vertex_descriptor> work;
+    //for each CC
+    for(auto vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi)
+      if(!visited.test((*vi)->descriptor()) and
+          !search_component<true>(g, (*vi)->descriptor(), vis, visited, work))
+        return;
+  }
+
+template<typename Graph, typename Visitor>
+  void depth_first_visit(const Graph& g, typename Graph::vertex_descriptor source,
+      Visitor& vis) {
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    if(g.find_vertex(source) == g.vertices_cend())
+      return;
+    descriptor_set<vertex_descriptor> visited;
+    std::vector<vertex_descriptor> work;
+    search_component<true>(g, source, vis, visited, work);
+  }
+
+
+
+///@brief One vertex reached by a lazy search: the vertex, the vertex it was
+///       discovered from (-1 for the source) and its depth in the search tree.
+template<typename VertexDescriptor>
+struct search_step {
+  VertexDescriptor vertex;
+  VertexDescriptor parent;
+  size_t depth;
+};
+
+///@brief Lazy single-source search, breadth-first or (LastInFirstOut)
+///       depth-first, as a range of search_steps in discovery order - the
+///       order breadth_first_visit and depth_first_visit discover vertices
+///       in. A vertex is expanded only when the consumer has taken every
+///       vertex discovered so far, so breaking out of a range-for after k
+///       steps costs about k expansions; the state is the visited set and
+///       the discovered-but-unexpanded vertices. The range is single-pass and
+///       refers to g, which must outlive it and not change while it is used.
+template<bool LastInFirstOut, typename Graph>
+class search_range {
+  public:
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    typedef search_step<vertex_descriptor> value_type;
+
+    class iterator {
+      public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef search_step<vertex_descriptor> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef const value_type& reference;
+
+        iterator() : m_range(nullptr) { }
+
+        reference operator*() const {return m_range->current();}
+        pointer operator->() const {return &m_range->current();}
+        iterator& operator++() {
+          m_range->advance();
+          return *this;
+        }
+        bool operator==(const iterator& i) const {return done() == i.done();}
+        bool operator!=(const iterator& i) const {return done() != i.done();}
+
+      private:
+        explicit iterator(search_range* r) : m_range(r) { }
+        bool done() const {return !m_range or m_range->empty();}
+
+        search_range* m_range; //< Null for end()
+
+        friend class search_range;
+    };
+
+    ///@brief Search g from source; empty if source is not in g.
+    search_range(const Graph& g, vertex_descriptor source) : m_graph(&g), m_pos(0) {
+      if(g.find_vertex(source) == g.vertices_cend())
+        return;
+      m_visited.set(source);
+      m_work.push_back({source, vertex_descriptor(-1), 0});
+    }
+
+    ///@brief The search continues from wherever it stands; see class comment.
+    iterator begin() {return iterator(this);}
+    iterator end() {return iterator();}
+
+    ///@brief True once every vertex reachable from source has been taken.
+    bool empty() const {return m_pos == m_work.size();}
+    const value_type& current() const {return m_work[m_pos];}
+
+    ///@brief Move to the next vertex, expanding pending vertices until one
+    ///       is discovered or none remain.
+    void advance() {
+      ++m_pos;
+      while(m_pos == m_work.size() and !m_work.empty()) {
+        value_type s;
+        if(LastInFirstOut) {
+          s = m_work.back();
+          m_work.pop_back();
+        }
+        else {
+          s = m_work.front();
+          m_work.pop_front();
+        }
+        m_pos = m_work.size();
+        expand(s);
+      }
+    }
+
+  private:
+    void expand(const value_type& s) {
+      GRAPH_STAT_ADD(vertices_visited, 1);
+      auto& v = *m_graph->find_vertex(s.vertex);
+      for(auto aei = v->begin(); aei != v->end(); ++aei) {
+        GRAPH_STAT_ADD(edges_examined, 1);
+        vertex_descriptor t = (*aei)->target();
+        if(!m_visited.test(t)) {
+          m_visited.set(t);
+          m_work.push_back({t, s.vertex, s.depth + 1});
+        }
+      }
+    }
+
+    const Graph* m_graph;                          //< Searched graph
+    descriptor_set<vertex_descriptor> m_visited;   //< Discovered vertices
+    std::deque<value_type> m_work;                 //< Unexpanded vertices; the
+                                                   //  taken ones precede m_pos
+    size_t m_pos;                                  //< Current step in m_work
+};
+
+///@brief Lazy breadth-first search from source:
+///       for(const auto& s : breadth_first_range(g, source)) ...
+template<typename Graph>
+  search_range<false, Graph> breadth_first_range(const Graph& g,
+      typename Graph::vertex_descriptor source) {
+    return search_range<false, Graph>(g, source);
+  }
+
+///@brief Lazy depth-first search from source, discovering vertices like
+///       depth_first_visit.
+template<typename Graph>
+  search_range<true, Graph> depth_first_range(const Graph& g,
+      typename Graph::vertex_descriptor source) {
+    return search_range<true, Graph>(g, source);
+  }
+
 ///@brief Implement breadth-first search.
 template<typename Graph, typename ParentMap>
   void breadth_first_search(const Graph& g, ParentMap& p) {
+    reset_property_map(p, g);
+    parent_recorder<ParentMap> vis(p);
+    breadth_first_visit(g, vis);
+  }
+
+
+///@brief Direction-optimizing breadth-first search (Beamer et al.). Visited
+///       and frontier state are bitmaps indexed by descriptor. Each level is
+///       expanded top-down from the frontier queue or, once the frontier's
+///       out-edges outnumber the unexplored edges by more than 1/alpha
+///       and the frontier grew, bottom-up by letting every unvisited vertex
+///       scan its in-edges for a frontier parent; it switches back when the
+///       frontier shrank to below n/beta vertices. A bottom-up step that
+///       inspects more edges than the top-down step would have (as on
+///       meshes, where few vertices find a parent early) is finished
+///       top-down, and the component stays top-down. Fills p like
+///       breadth_first_search (trees may differ, levels do not). On a graph
+///       that does not track in-edges every level is expanded top-down.
+///@return Number of edges inspected.
+template<typename Graph, typename ParentMap>
+  size_t direction_optimizing_breadth_first_search(const Graph& g, ParentMap& p,
+      size_t alpha = 15, size_t beta = 18) {
     typedef typename Graph::vertex_descriptor vertex_descriptor;
-    typedef typename Graph::edge_descriptor edge_descriptor;
     typedef typename Graph::const_vertex_iterator vertex_iterator;
-    typedef typename Graph::const_edge_iterator edge_iterator;
     typedef typename Graph::const_adj_edge_iterator adj_edge_iterator;
 
-    //setup
-    std::queue<vertex_descriptor> q;
-    std::unordered_set<edge_descriptor, boost::hash<edge_descriptor>> edges_unexplored;
-    std::unordered_set<vertex_descriptor> vertices_unexplored;
-
-    //initialize
-    p.clear();
+    //setup: descriptor-indexed vertex table and out-degrees
+    size_t bound = vertex_descriptor_bound(g);
+    std::vector<vertex_iterator> table(bound, g.vertices_cend());
+    std::vector<size_t> degree(bound, 0);
+    reset_property_map(p, g);
     for(vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
       vertex_descriptor vd = (*vi)->descriptor();
-      vertices_unexplored.emplace(vd);
+      table[vd] = vi;
+      degree[vd] = std::distance((*vi)->begin(), (*vi)->end());
       p[vd] = -1;
     }
-    for(edge_iterator ei = g.edges_cbegin(); ei != g.edges_cend(); ++ei)
-      edges_unexplored.emplace((*ei)->descriptor());
+
+    descriptor_bitmap visited(bound), frontier(bound);
+    std::vector<vertex_descriptor> queue, next_queue;
+    size_t inspected = 0;
+    size_t edges_unexplored = g.num_edges();
 
     //for each CC
     for(vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
-      vertex_descriptor vd = (*vi)->descriptor();
-      if(vertices_unexplored.count(vd)) {
-        q.push(vd);
-        vertices_unexplored.erase(vd);
-        while(!q.empty()) {
-          vertex_descriptor vd = q.front();
-          q.pop();
-          auto& v = *g.find_vertex(vd);
-          for(adj_edge_iterator aei = v->begin(); aei != v->end(); ++aei) {
-            auto el = edges_unexplored.find((*aei)->descriptor());
-            if(el != edges_unexplored.end()) {
+      vertex_descriptor root = (*vi)->descriptor();
+      if(visited.test(root))
+        continue;
+      visited.set(root);
+      edges_unexplored -= degree[root];
+      queue.assign(1, root);
+      size_t frontier_edges = degree[root];
+      size_t previous = 1;
+      bool bottom_up = false, top_down_only = !g.tracks_in_edges();
+
+      while(!queue.empty()) {
+        if(!bottom_up and !top_down_only and queue.size() > previous and
+            frontier_edges > edges_unexplored / alpha) {
+          bottom_up = true;
+        }
+        else if(bottom_up and queue.size() < previous and
+            queue.size() < g.num_vertices() / beta) {
+          bottom_up = false;
+        }
+        previous = queue.size();
+
+        //a bottom-up step may inspect no more edges than top-down would
+        size_t budget = frontier_edges;
+        next_queue.clear();
+        frontier_edges = 0;
+        if(bottom_up) {
+          frontier.reset();
+          for(vertex_descriptor u : queue)
+            frontier.set(u);
+          size_t spent = 0;
+          for(vertex_iterator wi = g.vertices_cbegin(); wi != g.vertices_cend() and spent <= budget; ++wi) {
+            auto& w = *wi;
+            vertex_descriptor t = w->descriptor();
+            if(visited.test(t))
+              continue;
+            for(adj_edge_iterator aei = w->in_edges_begin(); aei != w->in_edges_end(); ++aei) {
+              ++spent;
+              vertex_descriptor u = (*aei)->source();
+              if(frontier.test(u)) {
+                //discovery edge
+                p[t] = u;
+                visited.set(t);
+                next_queue.push_back(t);
+                edges_unexplored -= degree[t];
+                frontier_edges += degree[t];
+                break;
+              }
+            }
+          }
+          inspected += spent;
+          //over budget: no early exits to gain here, so finish the level
+          //top-down and stay there for the rest of the component
+          if(spent > budget) {
+            bottom_up = false;
+            top_down_only = true;
+          }
+        }
+        if(!bottom_up) {
+          for(vertex_descriptor u : queue) {
+            auto& v = *table[u];
+            for(adj_edge_iterator aei = v->begin(); aei != v->end(); ++aei) {
+              ++inspected;
               vertex_descriptor t = (*aei)->target();
-              if(vertices_unexplored.count(t)) {
+              if(!visited.test(t)) {
                 //discovery edge
-                edges_unexplored.erase(el);
-                p[t] = v->descriptor();
-                q.push(t);
-                vertices_unexplored.erase(t);
+                p[t] = u;
+                visited.set(t);
+                next_queue.push_back(t);
+                edges_unexplored -= degree[t];
+                frontier_edges += degree[t];
               }
-              //else cross edge
             }
           }
         }
+        queue.swap(next_queue);
       }
     }
+    GRAPH_STAT_ADD(vertices_visited, g.num_vertices());
+    GRAPH_STAT_ADD(edges_examined, inspected);
+    return inspected;
   }
 
 
-///@todo Implement depth-first search.
+///@brief Depth-first search.
 template<typename Graph, typename ParentMap>
-void depth_first_search(const Graph& g, ParentMap& p){
-	typedef typename Graph::vertex_descriptor vertex_descriptor;
-  typedef typename Graph::edge_descriptor edge_descriptor;
-  typedef typename Graph::const_vertex_iterator vertex_iterator;
-  typedef typename Graph::const_edge_iterator edge_iterator;
-  typedef typename Graph::const_adj_edge_iterator adj_edge_iterator;
-
-  //setup
-  std::stack<vertex_descriptor> s;
-  std::unordered_set<edge_descriptor, boost::hash<edge_descriptor>> edges_unexplored;
-  std::unordered_set<vertex_descriptor> vertices_unexplored;
-
-  //initialize
-  p.clear();
-  for(vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
-    vertex_descriptor vd = (*vi)->descriptor();
-    vertices_unexplored.emplace(vd);
-    p[vd] = -1;
-  }
-  for(edge_iterator ei = g.edges_cbegin(); ei != g.edges_cend(); ++ei)
-    edges_unexplored.emplace((*ei)->descriptor());
-
-  for (vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
-    vertex_descriptor vd = (*vi)->descriptor();
-    if (vertices_unexplored.count(vd)) {
-      s.push(vd);
-      vertices_unexplored.erase(vd);
-      while (!s.empty()) {
-        vertex_descriptor vd = s.top();
-        s.pop();
-        auto& v = *g.find_vertex(vd);
-        for (adj_edge_iterator aei = v->begin(); aei != v->end(); ++aei) {
-          auto el = edges_unexplored.find((*aei)->descriptor());
-          if (el != edges_unexplored.end()) {
-            vertex_descriptor t = (*aei)->target();
-            if (vertices_unexplored.count(t)) {
-              edges_unexplored.erase(el);
-              p[t] = v->descriptor();
-              s.push(t);
-              vertices_unexplored.erase(t);
-            }
+  void depth_first_search(const Graph& g, ParentMap& p) {
+    reset_property_map(p, g);
+    parent_recorder<ParentMap> vis(p);
+    depth_first_visit(g, vis);
+  }
+
+
+///@brief Breadth-first depths from many sources at once (multi-source BFS,
+///       Then et al.). Sources are taken 64 at a time, one bit of a machine
+///       word each: every vertex keeps a word of the searches that have seen
+///       it and a word of those whose frontier it is in, so one pass over an
+///       adjacency list advances every search in the batch and a level costs
+///       one sweep of the descriptor table however many sources share it.
+///       Fills depth[i] with the hop count from sources[i] to each vertex it
+///       reaches along out-edges (0 for the source itself); a source not in g
+///       reaches nothing.
+template<typename Graph, typename DepthMap>
+  void multi_source_breadth_first_search(const Graph& g,
+      const std::vector<typename Graph::vertex_descriptor>& sources,
+      std::vector<DepthMap>& depth) {
+    typedef typename Graph::const_vertex_iterator vertex_iterator;
+    typedef typename Graph::const_adj_edge_iterator adj_edge_iterator;
+    const size_t width = 64;
+
+    //setup: descriptor-indexed vertex table and per-vertex source words
+    size_t bound = vertex_descriptor_bound(g);
+    std::vector<vertex_iterator> table(bound, g.vertices_cend());
+    for(vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi)
+      table[(*vi)->descriptor()] = vi;
+    std::vector<uint64_t> seen(bound), visit(bound), visit_next(bound);
+    depth.resize(sources.size());
+    for(DepthMap& m : depth)
+      reset_property_map(m, g);
+
+    for(size_t first = 0; first < sources.size(); first += width) {
+      size_t batch = std::min(width, sources.size() - first);
+      std::fill(seen.begin(), seen.end(), 0);
+      std::fill(visit.begin(), visit.end(), 0);
+      bool active = false;
+      for(size_t i = 0; i < batch; ++i) {
+        size_t s = sources[first + i];
+        if(s >= bound or table[s] == g.vertices_cend())
+          continue;
+        seen[s] |= uint64_t(1) << i;
+        visit[s] |= uint64_t(1) << i;
+        depth[first + i][s] = 0;
+        active = true;
+      }
+
+      for(size_t level = 1; active; ++level) {
+        //push every frontier word along the out-edges
+        for(size_t v = 0; v < bound; ++v) {
+          if(!visit[v])
+            continue;
+          GRAPH_STAT_ADD(vertices_visited, 1);
+          auto& u = *table[v];
+          for(adj_edge_iterator aei = u->begin(); aei != u->end(); ++aei) {
+            GRAPH_STAT_ADD(edges_examined, 1);
+            visit_next[(*aei)->target()] |= visit[v];
           }
         }
+        //keep the searches that reach a vertex for the first time
+        active = false;
+        for(size_t v = 0; v < bound; ++v) {
+          uint64_t fresh = visit_next[v] & ~seen[v];
+          visit_next[v] = 0;
+          visit[v] = fresh;
+          if(!fresh)
+            continue;
+          seen[v] |= fresh;
+          active = true;
+          for(uint64_t m = fresh; m; m &= m - 1)
+            depth[first + __builtin_ctzll(m)][v] = level;
+        }
+      }
+    }
+  }
+
+
+///@brief Dijkstra's single-source shortest paths over non-negative edge
+///       properties. Tentative distances live in a 4-ary indexed heap keyed
+///       by descriptor, so an improved distance is a decrease-key in place
+///       rather than a duplicate entry. Fills p for every vertex (-1 for the
+///       source and for unreachable vertices) and d for the vertices
+///       reachable from source; the source's distance is a value-initialized
+///       EdgeProperty (zero).
+template<typename Graph, typename ParentMap, typename DistanceMap>
+  void dijkstra_shortest_paths(const Graph& g,
+      typename Graph::vertex_descriptor source, ParentMap& p, DistanceMap& d) {
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    typedef typename Graph::const_vertex_iterator vertex_iterator;
+    typedef typename Graph::const_adj_edge_iterator adj_edge_iterator;
+    typedef typename DistanceMap::mapped_type distance;
+
+    //setup: descriptor-indexed vertex table
+    size_t bound = vertex_descriptor_bound(g);
+    std::vector<vertex_iterator> table(bound, g.vertices_cend());
+    reset_property_map(p, g);
+    reset_property_map(d, g);
+    for(vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
+      table[(*vi)->descriptor()] = vi;
+      p[(*vi)->descriptor()] = -1;
+    }
+    if(source >= bound or table[source] == g.vertices_cend())
+      return;
+
+    std::vector<vertex_descriptor> parent(bound, vertex_descriptor(-1));
+    descriptor_bitmap settled(bound);
+    indexed_heap<distance> heap(bound);
+    heap.push(source, distance());
+
+    while(!heap.empty()) {
+      vertex_descriptor u = heap.top().second;
+      distance du = heap.top().first;
+      heap.pop();
+      settled.set(u);
+      d[u] = du;
+      p[u] = parent[u];
+      GRAPH_STAT_ADD(vertices_visited, 1);
+
+      auto& v = *table[u];
+      for(adj_edge_iterator aei = v->begin(); aei != v->end(); ++aei) {
+        GRAPH_STAT_ADD(edges_examined, 1);
+        vertex_descriptor t = (*aei)->target();
+        if(!settled.test(t) and heap.push_or_decrease(t, du + (*aei)->property()))
+          parent[t] = u;
       }
     }
   }
-}
+
+
+///@brief Connected components, taking edges as undirected (weakly connected
+///       components for directed graphs). A union-find over descriptor-
+///       indexed arrays, with path halving and union by rank, merges the
+///       endpoints of every edge in one pass; no traversal state is kept.
+///       Labels each vertex in c with the smallest descriptor in its
+///       component.
+///@return Number of components.
+template<typename Graph, typename ComponentMap>
+  size_t connected_components(const Graph& g, ComponentMap& c) {
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    typedef typename Graph::const_edge_iterator edge_iterator;
+    typedef typename Graph::const_vertex_iterator vertex_iterator;
+
+    //setup: every vertex its own set, labeled by itself
+    size_t bound = vertex_descriptor_bound(g);
+    std::vector<size_t> parent(bound), label(bound);
+    std::vector<unsigned char> rank(bound, 0);
+    for(size_t i = 0; i < bound; ++i)
+      parent[i] = label[i] = i;
+
+    auto find = [&](size_t x) {
+      while(parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+      }
+      return x;
+    };
+
+    for(edge_iterator ei = g.edges_cbegin(); ei != g.edges_cend(); ++ei) {
+      size_t a = find((*ei)->source()), b = find((*ei)->target());
+      if(a == b)
+        continue;
+      if(rank[a] < rank[b])
+        std::swap(a, b);
+      parent[b] = a;
+      rank[a] += rank[a] == rank[b];
+      label[a] = std::min(label[a], label[b]);
+    }
+
+    reset_property_map(c, g);
+    size_t count = 0;
+    for(vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
+      vertex_descriptor vd = (*vi)->descriptor();
+      size_t root = find(vd);
+      c[vd] = label[root];
+      count += root == vd;
+    }
+    GRAPH_STAT_ADD(vertices_visited, g.num_vertices());
+    GRAPH_STAT_ADD(edges_examined, g.num_edges());
+    return count;
+  }
 
 #endif
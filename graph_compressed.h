@@ -0,0 +1,389 @@
+#ifndef _GRAPH_COMPRESSED_H_
+#define _GRAPH_COMPRESSED_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// An immutable, compressed snapshot of a finished graph for graphs that do
+/// not fit in memory as graph or graph_vector. Like graph_csr, vertices take
+/// dense slots in descriptor order and each row of out-edges is sorted by
+/// target, but a row is stored as variable-length integers (7 bits per byte,
+/// high bit set on all but the last byte): the first target relative to the
+/// source, zigzag-encoded, then the gaps between consecutive targets. Edge
+/// properties sit uncompressed in an array parallel to the decoded order.
+/// Sparse rows of nearby targets take one or two bytes per edge instead of
+/// eight, and the descriptor tables are dropped when descriptors have no
+/// holes.
+///
+/// Adjacency iterators decode on the fly, so graph_algorithms.h runs on it
+/// unchanged; find_edge scans the source's row. As with graph_csr,
+/// dereferencing an iterator yields a light handle by value.
+////////////////////////////////////////////////////////////////////////////////
+template<typename VertexProperty, typename EdgeProperty>
+class graph_compressed {
+
+  class vertex;
+  class edge;
+
+  public:
+
+    // Required public types
+
+    /// Unique vertex identifier
+    typedef size_t vertex_descriptor;
+
+    /// Unique edge identifier represents pair of vertex descriptors
+    typedef std::pair<size_t, size_t> edge_descriptor;
+
+    class const_vertex_iterator;
+    class const_edge_iterator;
+    typedef const_edge_iterator const_adj_edge_iterator;
+
+    // The snapshot is read-only, so the mutable iterators are the const ones.
+    typedef const_vertex_iterator vertex_iterator;
+    typedef const_edge_iterator edge_iterator;
+    typedef const_adj_edge_iterator adj_edge_iterator;
+
+    /// Marks a hole in the descriptor -> slot table.
+    static constexpr size_t npos = size_t(-1);
+
+    ///@brief Build the snapshot in one pass over a finished graph or
+    ///       graph_vector.
+    template<typename Graph>
+    explicit graph_compressed(const Graph& g) : m_num_edges(0) {
+      typedef typename Graph::const_vertex_iterator source_vertex_iterator;
+      typedef typename Graph::const_adj_edge_iterator source_adj_edge_iterator;
+
+      // Collect vertices and order them by descriptor, i.e. insertion order.
+      std::vector<std::pair<vertex_descriptor, source_vertex_iterator>> order;
+      order.reserve(g.num_vertices());
+      vertex_descriptor max_vd = 0;
+      for(source_vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
+        order.emplace_back((*vi)->descriptor(), vi);
+        max_vd = std::max(max_vd, (*vi)->descriptor() + 1);
+      }
+      std::sort(order.begin(), order.end(),
+          [](const std::pair<vertex_descriptor, source_vertex_iterator>& a,
+             const std::pair<vertex_descriptor, source_vertex_iterator>& b) {
+          return a.first < b.first;
+          });
+
+      // Descriptors 0..n-1 need no translation tables.
+      if(max_vd != order.size()) {
+        m_slots.assign(max_vd, npos);
+        m_descriptors.reserve(order.size());
+      }
+      m_vertex_properties.reserve(order.size());
+      m_byte_offsets.reserve(order.size() + 1);
+      m_edge_offsets.reserve(order.size() + 1);
+      m_edge_properties.reserve(g.num_edges());
+
+      std::vector<std::pair<vertex_descriptor, EdgeProperty>> row;
+      m_byte_offsets.push_back(0);
+      m_edge_offsets.push_back(0);
+      for(const auto& o : order) {
+        const auto& v = *o.second;
+        if(!m_slots.empty()) {
+          m_slots[o.first] = m_descriptors.size();
+          m_descriptors.push_back(o.first);
+        }
+        m_vertex_properties.push_back(v->property());
+
+        row.clear();
+        for(source_adj_edge_iterator aei = v->begin(); aei != v->end(); ++aei)
+          row.emplace_back((*aei)->target(), (*aei)->property());
+        std::sort(row.begin(), row.end(),
+            [](const std::pair<vertex_descriptor, EdgeProperty>& a,
+               const std::pair<vertex_descriptor, EdgeProperty>& b) {
+            return a.first < b.first;
+            });
+        vertex_descriptor previous = o.first;
+        for(size_t i = 0; i < row.size(); ++i) {
+          if(i == 0)
+            put_varint(zigzag(int64_t(row[i].first - previous)));
+          else
+            put_varint(row[i].first - previous);
+          previous = row[i].first;
+          m_edge_properties.push_back(row[i].second);
+        }
+        m_num_edges += row.size();
+        m_byte_offsets.push_back(m_bytes.size());
+        m_edge_offsets.push_back(m_num_edges);
+      }
+      m_bytes.shrink_to_fit();
+    }
+
+    graph_compressed(const graph_compressed&) = delete;             ///< Copy is disabled.
+    graph_compressed& operator=(const graph_compressed&) = delete;  ///< Copy is disabled.
+
+    ///@brief vertex iterator operations
+    const_vertex_iterator vertices_begin() const {return vertices_cbegin();}
+    const_vertex_iterator vertices_cbegin() const {return const_vertex_iterator(this, 0);}
+    const_vertex_iterator vertices_end() const {return vertices_cend();}
+    const_vertex_iterator vertices_cend() const {
+      return const_vertex_iterator(this, num_vertices());
+    }
+
+    ///@brief edge iterator operations
+    const_edge_iterator edges_begin() const {return edges_cbegin();}
+    const_edge_iterator edges_cbegin() const {return const_edge_iterator(this, 0, num_vertices());}
+    const_edge_iterator edges_end() const {return edges_cend();}
+    const_edge_iterator edges_cend() const {return const_edge_iterator(this);}
+
+    ///@brief Define accessors
+    size_t num_vertices() const {return m_vertex_properties.size();}
+    size_t num_edges() const {return m_num_edges;}
+
+    ///@brief Bytes held by the snapshot's arrays.
+    size_t memory_bytes() const {
+      return m_slots.capacity() * sizeof(size_t) +
+        m_descriptors.capacity() * sizeof(vertex_descriptor) +
+        m_vertex_properties.capacity() * sizeof(VertexProperty) +
+        m_byte_offsets.capacity() * sizeof(size_t) +
+        m_edge_offsets.capacity() * sizeof(size_t) +
+        m_bytes.capacity() + m_edge_properties.capacity() * sizeof(EdgeProperty);
+    }
+
+    const_vertex_iterator find_vertex(vertex_descriptor vd) const {
+      size_t s = slot(vd);
+      return s == npos ? vertices_cend() : const_vertex_iterator(this, s);
+    }
+
+    const_edge_iterator find_edge(edge_descriptor ed) const {
+      size_t s = slot(ed.first);
+      if(s == npos)
+        return edges_cend();
+      for(const_edge_iterator i(this, s, s + 1); i.m_index != m_edge_offsets[s + 1]; ++i) {
+        if(i.m_target == ed.second)
+          return const_edge_iterator(this, i);
+        if(i.m_target > ed.second)
+          break;
+      }
+      return edges_cend();
+    }
+
+    // Friend declaration for output.
+    template<typename V, typename E>
+    friend std::ostream& operator<<(std::ostream&, const graph_compressed<V, E>&);
+
+  private:
+    static uint64_t zigzag(int64_t x) {return (uint64_t(x) << 1) ^ uint64_t(x >> 63);}
+    static int64_t unzigzag(uint64_t x) {return int64_t(x >> 1) ^ -int64_t(x & 1);}
+
+    void put_varint(uint64_t x) {
+      while(x >= 0x80) {
+        m_bytes.push_back(uint8_t(x) | 0x80);
+        x >>= 7;
+      }
+      m_bytes.push_back(uint8_t(x));
+    }
+
+    static uint64_t get_varint(const uint8_t*& p) {
+      uint64_t x = *p++;
+      if(x < 0x80)
+        return x;
+      x &= 0x7F;
+      for(unsigned shift = 7;; shift += 7) {
+        uint64_t b = *p++;
+        x |= (b & 0x7F) << shift;
+        if(b < 0x80)
+          return x;
+      }
+    }
+
+    size_t slot(vertex_descriptor vd) const {
+      if(m_slots.empty())
+        return vd < num_vertices() ? vd : npos;
+      return vd < m_slots.size() ? m_slots[vd] : npos;
+    }
+
+    vertex_descriptor descriptor(size_t s) const {
+      return m_descriptors.empty() ? s : m_descriptors[s];
+    }
+
+    std::vector<size_t> m_slots;                      //< Descriptor -> slot, empty if the identity
+    std::vector<vertex_descriptor> m_descriptors;     //< Slot -> descriptor, empty if the identity
+    std::vector<VertexProperty> m_vertex_properties;  //< Slot -> property
+    std::vector<size_t> m_byte_offsets;               //< Slot -> first byte of its row, plus end
+    std::vector<size_t> m_edge_offsets;               //< Slot -> first out-edge, plus end
+    std::vector<uint8_t> m_bytes;                     //< Encoded rows
+    std::vector<EdgeProperty> m_edge_properties;      //< Out-edge properties in row order
+    size_t m_num_edges;                               //< Edges
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Handle to a vertex slot.
+    ////////////////////////////////////////////////////////////////////////////
+    class vertex {
+      public:
+        vertex(const graph_compressed* g, size_t s) : m_graph(g), m_slot(s) { }
+
+        const vertex* operator->() const {return this;}
+
+        //iterators
+        const_adj_edge_iterator begin() const {
+          return const_adj_edge_iterator(m_graph, m_slot, m_slot + 1);
+        }
+        const_adj_edge_iterator cbegin() const {return begin();}
+        const_adj_edge_iterator end() const {
+          return const_adj_edge_iterator(m_graph, m_graph->m_edge_offsets[m_slot + 1]);
+        }
+        const_adj_edge_iterator cend() const {return end();}
+
+        //accessors
+        vertex_descriptor descriptor() const {return m_graph->descriptor(m_slot);}
+        const VertexProperty& property() const {return m_graph->m_vertex_properties[m_slot];}
+
+      private:
+        const graph_compressed* m_graph;
+        size_t m_slot;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Decoded edge.
+    ////////////////////////////////////////////////////////////////////////////
+    class edge {
+      public:
+        edge(const graph_compressed* g, vertex_descriptor s, vertex_descriptor t, size_t i) :
+          m_graph(g), m_source(s), m_target(t), m_index(i) { }
+
+        const edge* operator->() const {return this;}
+
+        //accessors
+        vertex_descriptor source() const {return m_source;}
+        vertex_descriptor target() const {return m_target;}
+        edge_descriptor descriptor() const {return {m_source, m_target};}
+        const EdgeProperty& property() const {return m_graph->m_edge_properties[m_index];}
+
+      private:
+        const graph_compressed* m_graph;
+        vertex_descriptor m_source;
+        vertex_descriptor m_target;
+        size_t m_index;
+    };
+
+  public:
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Iterates vertex slots in descriptor order.
+    ////////////////////////////////////////////////////////////////////////////
+    class const_vertex_iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef vertex value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const vertex* pointer;
+        typedef const vertex reference;
+
+        const_vertex_iterator() : m_graph(nullptr), m_slot(0) { }
+        const_vertex_iterator(const graph_compressed* g, size_t s) : m_graph(g), m_slot(s) { }
+
+        const vertex operator*() const {return vertex(m_graph, m_slot);}
+        const_vertex_iterator& operator++() {++m_slot; return *this;}
+        const_vertex_iterator operator++(int) {auto t = *this; ++m_slot; return t;}
+        bool operator==(const const_vertex_iterator& o) const {return m_slot == o.m_slot;}
+        bool operator!=(const const_vertex_iterator& o) const {return m_slot != o.m_slot;}
+
+      private:
+        const graph_compressed* m_graph;
+        size_t m_slot;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Decodes the rows of the slots [slot, last_slot) in order; the out-edges
+    /// of one vertex are the range of a single row. Positions are compared by
+    /// edge index, so any iterator whose index is past the range ends it.
+    ////////////////////////////////////////////////////////////////////////////
+    class const_edge_iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef edge value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const edge* pointer;
+        typedef const edge reference;
+
+        const_edge_iterator() : m_graph(nullptr), m_pos(nullptr),
+          m_slot(0), m_last_slot(0), m_source(0), m_target(0), m_index(0) { }
+
+        const edge operator*() const {return edge(m_graph, m_source, m_target, m_index);}
+        const_edge_iterator& operator++() {
+          ++m_index;
+          if(m_index < m_graph->m_edge_offsets[m_slot + 1])
+            m_target += get_varint(m_pos);
+          else {
+            ++m_slot;
+            start_row();
+          }
+          return *this;
+        }
+        const_edge_iterator operator++(int) {auto t = *this; ++*this; return t;}
+        bool operator==(const const_edge_iterator& o) const {return m_index == o.m_index;}
+        bool operator!=(const const_edge_iterator& o) const {return m_index != o.m_index;}
+
+      private:
+        // The end position at edge index i.
+        explicit const_edge_iterator(const graph_compressed* g, size_t i = npos) :
+          m_graph(g), m_pos(nullptr), m_slot(0), m_last_slot(0),
+          m_source(0), m_target(0), m_index(i == npos ? g->m_num_edges : i) { }
+
+        // The first edge of the rows [slot, last_slot).
+        const_edge_iterator(const graph_compressed* g, size_t slot, size_t last_slot) :
+          m_graph(g), m_slot(slot), m_last_slot(last_slot) {
+          start_row();
+        }
+
+        // A position found by scanning within a row; it runs to the end of
+        // the whole graph.
+        const_edge_iterator(const graph_compressed* g, const const_edge_iterator& i) :
+          const_edge_iterator(i) {
+          m_last_slot = g->num_vertices();
+        }
+
+        // Decode the first edge of the next non-empty row from m_slot on.
+        void start_row() {
+          while(m_slot < m_last_slot and
+              m_graph->m_edge_offsets[m_slot] == m_graph->m_edge_offsets[m_slot + 1])
+            ++m_slot;
+          m_index = m_graph->m_edge_offsets[m_slot < m_last_slot ? m_slot : m_last_slot];
+          if(m_slot == m_last_slot)
+            return;
+          m_pos = m_graph->m_bytes.data() + m_graph->m_byte_offsets[m_slot];
+          m_source = m_graph->descriptor(m_slot);
+          m_target = m_source + unzigzag(get_varint(m_pos));
+        }
+
+        const graph_compressed* m_graph;
+        const uint8_t* m_pos;         //< Next byte to decode
+        size_t m_slot;                //< Row being decoded
+        size_t m_last_slot;           //< One past the last row to decode
+        vertex_descriptor m_source;   //< Descriptor of the row's vertex
+        vertex_descriptor m_target;   //< Target of the current edge
+        size_t m_index;               //< Index of the current edge
+
+        friend class graph_compressed;
+        friend class vertex;
+    };
+};
+
+template<typename V, typename E>
+constexpr size_t graph_compressed<V, E>::npos;
+
+///@brief Define output for the snapshot, in the same format as graph.
+template<typename V, typename E>
+std::ostream& operator<<(std::ostream& os, const graph_compressed<V, E>& g) {
+  os << g.num_vertices() << " " << g.num_edges() << std::endl;
+  for(auto i = g.vertices_cbegin(); i != g.vertices_cend(); ++i)
+    os << (*i)->property() << std::endl;
+  for(auto i = g.edges_cbegin(); i != g.edges_cend(); ++i)
+    os << (*i)->source() << " " << (*i)->target() << " "
+      << (*i)->property() << std::endl;
+  return os;
+}
+
+
+#endif
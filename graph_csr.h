@@ -0,0 +1,393 @@
+#ifndef _GRAPH_CSR_H_
+#define _GRAPH_CSR_H_
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// Read-only view of a contiguous array owned elsewhere.
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+class array_view {
+  public:
+    array_view() : m_data(nullptr), m_size(0) { }
+    array_view(const T* data, size_t size) : m_data(data), m_size(size) { }
+    array_view(const std::vector<T>& v) : m_data(v.data()), m_size(v.size()) { }
+
+    const T* data() const {return m_data;}
+    const T* begin() const {return m_data;}
+    const T* end() const {return m_data + m_size;}
+    size_t size() const {return m_size;}
+    const T& operator[](size_t i) const {return m_data[i];}
+
+  private:
+    const T* m_data;
+    size_t m_size;
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// An immutable compressed-sparse-row snapshot of a finished graph. Vertices
+/// occupy dense slots ordered by descriptor; the out-edges of slot i are the
+/// contiguous range [m_offsets[i], m_offsets[i+1]) of the target and property
+/// arrays, sorted by target. It exposes the same descriptor and iterator
+/// typedefs as graph and graph_vector so the searches in graph_algorithms.h
+/// run on it unchanged.
+///
+/// Dereferencing an iterator yields a light handle (by value) that forwards
+/// operator-> to itself, so (*vi)->descriptor() and
+/// auto& v = *g.find_vertex(vd) both work as they do for the pointer-based
+/// graphs.
+///
+/// The arrays are views; their storage is held by a shared owner, either the
+/// vectors filled when building from a graph or, for snapshots opened from
+/// disk (graph_snapshot.h), the file mapping itself.
+////////////////////////////////////////////////////////////////////////////////
+template<typename VertexProperty, typename EdgeProperty>
+class graph_csr {
+
+  class vertex;
+  class edge;
+
+  public:
+
+    // Required public types
+
+    /// Unique vertex identifier
+    typedef size_t vertex_descriptor;
+
+    /// Unique edge identifier represents pair of vertex descriptors
+    typedef std::pair<size_t, size_t> edge_descriptor;
+
+    class const_vertex_iterator;
+    class const_edge_iterator;
+    class const_adj_edge_iterator;
+
+    // The snapshot is read-only, so the mutable iterators are the const ones.
+    typedef const_vertex_iterator vertex_iterator;
+    typedef const_edge_iterator edge_iterator;
+    typedef const_adj_edge_iterator adj_edge_iterator;
+
+    ///@brief The arrays behind a snapshot.
+    struct arrays {
+      array_view<size_t> slots;                      //< Descriptor -> slot, npos for holes
+      array_view<vertex_descriptor> descriptors;     //< Slot -> descriptor
+      array_view<VertexProperty> vertex_properties;  //< Slot -> property
+      array_view<size_t> offsets;                    //< Slot -> first out-edge, plus end sentinel
+      array_view<vertex_descriptor> targets;         //< Out-edge targets, grouped by source, sorted
+      array_view<EdgeProperty> edge_properties;      //< Out-edge properties, parallel to targets
+    };
+
+    /// Marks a hole in the descriptor -> slot table.
+    static constexpr size_t npos = size_t(-1);
+
+    ///@brief Build the snapshot in one pass over a finished graph or
+    ///       graph_vector.
+    template<typename Graph>
+    explicit graph_csr(const Graph& g) {
+      typedef typename Graph::const_vertex_iterator source_vertex_iterator;
+      typedef typename Graph::const_adj_edge_iterator source_adj_edge_iterator;
+
+      // Collect vertices and order them by descriptor, i.e. insertion order.
+      std::vector<std::pair<vertex_descriptor, source_vertex_iterator>> order;
+      order.reserve(g.num_vertices());
+      vertex_descriptor max_vd = 0;
+      for(source_vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
+        order.emplace_back((*vi)->descriptor(), vi);
+        max_vd = std::max(max_vd, (*vi)->descriptor() + 1);
+      }
+      std::sort(order.begin(), order.end(),
+          [](const std::pair<vertex_descriptor, source_vertex_iterator>& a,
+             const std::pair<vertex_descriptor, source_vertex_iterator>& b) {
+          return a.first < b.first;
+          });
+
+      auto st = std::make_shared<storage>();
+      st->slots.assign(max_vd, npos);
+      st->descriptors.reserve(order.size());
+      st->vertex_properties.reserve(order.size());
+      st->offsets.reserve(order.size() + 1);
+      st->targets.reserve(g.num_edges());
+      st->edge_properties.reserve(g.num_edges());
+
+      std::vector<std::pair<vertex_descriptor, EdgeProperty>> row;
+      st->offsets.push_back(0);
+      for(const auto& o : order) {
+        const auto& v = *o.second;
+        st->slots[o.first] = st->descriptors.size();
+        st->descriptors.push_back(o.first);
+        st->vertex_properties.push_back(v->property());
+
+        row.clear();
+        for(source_adj_edge_iterator aei = v->begin(); aei != v->end(); ++aei)
+          row.emplace_back((*aei)->target(), (*aei)->property());
+        std::sort(row.begin(), row.end(),
+            [](const std::pair<vertex_descriptor, EdgeProperty>& a,
+               const std::pair<vertex_descriptor, EdgeProperty>& b) {
+            return a.first < b.first;
+            });
+        for(const auto& r : row) {
+          st->targets.push_back(r.first);
+          st->edge_properties.push_back(r.second);
+        }
+        st->offsets.push_back(st->targets.size());
+      }
+      adopt({st->slots, st->descriptors, st->vertex_properties,
+          st->offsets, st->targets, st->edge_properties}, st);
+    }
+
+    ///@brief Wrap arrays that already hold a snapshot, e.g. in a file
+    ///       mapping. owner keeps their storage alive.
+    graph_csr(const arrays& a, std::shared_ptr<const void> owner) {
+      adopt(a, std::move(owner));
+    }
+
+    graph_csr(const graph_csr&) = delete;             ///< Copy is disabled.
+    graph_csr& operator=(const graph_csr&) = delete;  ///< Copy is disabled.
+
+    ///@brief vertex iterator operations
+    const_vertex_iterator vertices_begin() const {return vertices_cbegin();}
+    const_vertex_iterator vertices_cbegin() const {return const_vertex_iterator(this, 0);}
+    const_vertex_iterator vertices_end() const {return vertices_cend();}
+    const_vertex_iterator vertices_cend() const {
+      return const_vertex_iterator(this, m_descriptors.size());
+    }
+
+    ///@brief edge iterator operations
+    const_edge_iterator edges_begin() const {return edges_cbegin();}
+    const_edge_iterator edges_cbegin() const {return const_edge_iterator(this, 0, 0);}
+    const_edge_iterator edges_end() const {return edges_cend();}
+    const_edge_iterator edges_cend() const {
+      return const_edge_iterator(this, m_descriptors.size(), m_targets.size());
+    }
+
+    ///@brief Define accessors
+    size_t num_vertices() const {return m_descriptors.size();}
+    size_t num_edges() const {return m_targets.size();}
+    arrays data() const {
+      return {m_slots, m_descriptors, m_vertex_properties,
+        m_offsets, m_targets, m_edge_properties};
+    }
+
+    const_vertex_iterator find_vertex(vertex_descriptor vd) const {
+      size_t s = slot(vd);
+      return s == npos ? vertices_cend() : const_vertex_iterator(this, s);
+    }
+
+    const_edge_iterator find_edge(edge_descriptor ed) const {
+      size_t s = slot(ed.first);
+      if(s == npos)
+        return edges_cend();
+      auto first = m_targets.begin() + m_offsets[s];
+      auto last = m_targets.begin() + m_offsets[s + 1];
+      auto t = std::lower_bound(first, last, ed.second);
+      if(t == last or *t != ed.second)
+        return edges_cend();
+      return const_edge_iterator(this, s, t - m_targets.begin());
+    }
+
+    // Friend declaration for output.
+    template<typename V, typename E>
+    friend std::ostream& operator<<(std::ostream&, const graph_csr<V, E>&);
+
+  private:
+    // Owned storage of a snapshot built from a graph.
+    struct storage {
+      std::vector<size_t> slots;
+      std::vector<vertex_descriptor> descriptors;
+      std::vector<VertexProperty> vertex_properties;
+      std::vector<size_t> offsets;
+      std::vector<vertex_descriptor> targets;
+      std::vector<EdgeProperty> edge_properties;
+    };
+
+    void adopt(const arrays& a, std::shared_ptr<const void> owner) {
+      m_slots = a.slots;
+      m_descriptors = a.descriptors;
+      m_vertex_properties = a.vertex_properties;
+      m_offsets = a.offsets;
+      m_targets = a.targets;
+      m_edge_properties = a.edge_properties;
+      m_owner = std::move(owner);
+    }
+
+    size_t slot(vertex_descriptor vd) const {
+      return vd < m_slots.size() ? m_slots[vd] : npos;
+    }
+
+    array_view<size_t> m_slots;                      //< Descriptor -> slot, npos for holes
+    array_view<vertex_descriptor> m_descriptors;     //< Slot -> descriptor
+    array_view<VertexProperty> m_vertex_properties;  //< Slot -> property
+    array_view<size_t> m_offsets;                    //< Slot -> first out-edge, plus end sentinel
+    array_view<vertex_descriptor> m_targets;         //< Out-edge targets, grouped by source
+    array_view<EdgeProperty> m_edge_properties;      //< Out-edge properties, parallel to m_targets
+    std::shared_ptr<const void> m_owner;             //< Keeps the arrays alive
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Handle to a vertex slot.
+    ////////////////////////////////////////////////////////////////////////////
+    class vertex {
+      public:
+        vertex(const graph_csr* g, size_t s) : m_graph(g), m_slot(s) { }
+
+        const vertex* operator->() const {return this;}
+
+        //iterators
+        const_adj_edge_iterator begin() const {
+          return const_adj_edge_iterator(m_graph, m_slot, m_graph->m_offsets[m_slot]);
+        }
+        const_adj_edge_iterator cbegin() const {return begin();}
+        const_adj_edge_iterator end() const {
+          return const_adj_edge_iterator(m_graph, m_slot, m_graph->m_offsets[m_slot + 1]);
+        }
+        const_adj_edge_iterator cend() const {return end();}
+
+        //accessors
+        vertex_descriptor descriptor() const {return m_graph->m_descriptors[m_slot];}
+        const VertexProperty& property() const {return m_graph->m_vertex_properties[m_slot];}
+
+      private:
+        const graph_csr* m_graph;
+        size_t m_slot;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Handle to an edge position in the target/property arrays.
+    ////////////////////////////////////////////////////////////////////////////
+    class edge {
+      public:
+        edge(const graph_csr* g, size_t s, size_t i) :
+          m_graph(g), m_slot(s), m_index(i) { }
+
+        const edge* operator->() const {return this;}
+
+        //accessors
+        vertex_descriptor source() const {return m_graph->m_descriptors[m_slot];}
+        vertex_descriptor target() const {return m_graph->m_targets[m_index];}
+        edge_descriptor descriptor() const {return {source(), target()};}
+        const EdgeProperty& property() const {return m_graph->m_edge_properties[m_index];}
+
+      private:
+        const graph_csr* m_graph;
+        size_t m_slot;
+        size_t m_index;
+    };
+
+  public:
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Iterates vertex slots in descriptor order.
+    ////////////////////////////////////////////////////////////////////////////
+    class const_vertex_iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef vertex value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const vertex* pointer;
+        typedef const vertex reference;
+
+        const_vertex_iterator() : m_graph(nullptr), m_slot(0) { }
+        const_vertex_iterator(const graph_csr* g, size_t s) : m_graph(g), m_slot(s) { }
+
+        const vertex operator*() const {return vertex(m_graph, m_slot);}
+        const_vertex_iterator& operator++() {++m_slot; return *this;}
+        const_vertex_iterator operator++(int) {auto t = *this; ++m_slot; return t;}
+        bool operator==(const const_vertex_iterator& o) const {return m_slot == o.m_slot;}
+        bool operator!=(const const_vertex_iterator& o) const {return m_slot != o.m_slot;}
+
+      private:
+        const graph_csr* m_graph;
+        size_t m_slot;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Iterates the out-edges of a single vertex.
+    ////////////////////////////////////////////////////////////////////////////
+    class const_adj_edge_iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef edge value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const edge* pointer;
+        typedef const edge reference;
+
+        const_adj_edge_iterator() : m_graph(nullptr), m_slot(0), m_index(0) { }
+        const_adj_edge_iterator(const graph_csr* g, size_t s, size_t i) :
+          m_graph(g), m_slot(s), m_index(i) { }
+
+        const edge operator*() const {return edge(m_graph, m_slot, m_index);}
+        const_adj_edge_iterator& operator++() {++m_index; return *this;}
+        const_adj_edge_iterator operator++(int) {auto t = *this; ++m_index; return t;}
+        bool operator==(const const_adj_edge_iterator& o) const {return m_index == o.m_index;}
+        bool operator!=(const const_adj_edge_iterator& o) const {return m_index != o.m_index;}
+
+      private:
+        const graph_csr* m_graph;
+        size_t m_slot;
+        size_t m_index;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Iterates every edge, row by row.
+    ////////////////////////////////////////////////////////////////////////////
+    class const_edge_iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef edge value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const edge* pointer;
+        typedef const edge reference;
+
+        const_edge_iterator() : m_graph(nullptr), m_slot(0), m_index(0) { }
+        const_edge_iterator(const graph_csr* g, size_t s, size_t i) :
+          m_graph(g), m_slot(s), m_index(i) {
+          skip_empty_rows();
+        }
+
+        const edge operator*() const {return edge(m_graph, m_slot, m_index);}
+        const_edge_iterator& operator++() {
+          ++m_index;
+          skip_empty_rows();
+          return *this;
+        }
+        const_edge_iterator operator++(int) {auto t = *this; ++*this; return t;}
+        bool operator==(const const_edge_iterator& o) const {return m_index == o.m_index;}
+        bool operator!=(const const_edge_iterator& o) const {return m_index != o.m_index;}
+
+      private:
+        void skip_empty_rows() {
+          if(!m_graph)
+            return;
+          size_t n = m_graph->m_descriptors.size();
+          while(m_slot < n and m_index == m_graph->m_offsets[m_slot + 1])
+            ++m_slot;
+        }
+
+        const graph_csr* m_graph;
+        size_t m_slot;
+        size_t m_index;
+    };
+};
+
+template<typename V, typename E>
+constexpr size_t graph_csr<V, E>::npos;
+
+///@brief Define output for the snapshot, in the same format as graph.
+template<typename V, typename E>
+std::ostream& operator<<(std::ostream& os, const graph_csr<V, E>& g) {
+  os << g.num_vertices() << " " << g.num_edges() << std::endl;
+  for(auto i = g.vertices_cbegin(); i != g.vertices_cend(); ++i)
+    os << (*i)->property() << std::endl;
+  for(auto i = g.edges_cbegin(); i != g.edges_cend(); ++i)
+    os << (*i)->source() << " " << (*i)->target() << " "
+      << (*i)->property() << std::endl;
+  return os;
+}
+
+
+#endif
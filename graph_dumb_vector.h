@@ -3,11 +3,18 @@
 
 #include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <tuple>
 #include <vector>
 
+#include "graph_stats.h"
+#include "small_vector.h"
 
-template<typename VertexProperty, typename EdgeProperty>
+
+//adjacency lists keep their first InlineEdges edges inside the vertex and
+//only allocate once a vertex's degree passes that
+template<typename VertexProperty, typename EdgeProperty, size_t InlineEdges = 4>
   class graph_vector {
 
     //you have to forward declare these so you can use them in the public
@@ -25,9 +32,13 @@ template<typename VertexProperty, typename EdgeProperty>
                                                     //represents pair of vertex
                                                     //descriptors
 
+      typedef std::tuple<size_t, size_t, EdgeProperty> edge_triple; //source, target
+                                                    //and property, as taken
+                                                    //by insert_edges
+
       typedef std::vector<vertex*> vertex_storage;
       typedef std::vector<edge*> edge_storage;
-      typedef std::vector<edge*> adj_edge_storage;
+      typedef small_vector<edge*, InlineEdges> adj_edge_storage;
       //vertex container should contain "vertex*" or shared_ptr<vertex>
       typedef typename vertex_storage::iterator vertex_iterator; //vertex iterators
       typedef typename vertex_storage::const_iterator const_vertex_iterator;
@@ -40,8 +51,11 @@ template<typename VertexProperty, typename EdgeProperty>
       typedef typename adj_edge_storage::iterator adj_edge_iterator; //adjacency list iterators
       typedef typename adj_edge_storage::const_iterator const_adj_edge_iterator;
 
-      ///required constructor/destructors
-      graph_vector() : m_max_vd(0) { }
+      ///required constructor/destructors. With track_in_edges every vertex
+      ///also keeps its in-edges, so erase_vertex only touches incident edges
+      ///and in_edges_begin/end are available.
+      explicit graph_vector(bool track_in_edges = true) :
+        m_max_vd(0), m_track_in_edges(track_in_edges) { }
 
       ~graph_vector() {
         clear();
@@ -66,58 +80,50 @@ template<typename VertexProperty, typename EdgeProperty>
       //accessors
       size_t num_vertices() const {return m_vertices.size();}
       size_t num_edges() const {return m_edges.size();}
+      bool tracks_in_edges() const {return m_track_in_edges;}
 
+      // find_vertex is a lookup in the descriptor index; find_edge only
+      // scans the out-edges of the source vertex.
       vertex_iterator find_vertex(vertex_descriptor vd) {
-        return std::find_if(m_vertices.begin(), m_vertices.end(),
-            [&](const vertex* const v) {
-            return v->descriptor() == vd;
-            });
+        return m_vertices.begin() + slot(vd);
       }
 
       const_vertex_iterator find_vertex(vertex_descriptor vd) const {
-        return std::find_if(m_vertices.cbegin(), m_vertices.cend(),
-            [&](const vertex* const v) {
-            return v->descriptor() == vd;
-            });
+        return m_vertices.cbegin() + slot(vd);
       }
 
       edge_iterator find_edge(edge_descriptor ed) {
-        return std::find_if(m_edges.begin(), m_edges.end(),
-            [&](const edge* const e) {
-            return e->descriptor() == ed;
-            });
+        return m_edges.begin() + edge_index(ed);
       }
 
       const_edge_iterator find_edge(edge_descriptor ed) const {
-        return std::find_if(m_edges.cbegin(), m_edges.cend(),
-            [&](const edge* e) {
-            return e->descriptor() == ed;
-            });
+        return m_edges.cbegin() + edge_index(ed);
       }
 
       ///@todo modifiers
       vertex_descriptor insert_vertex(const VertexProperty& vp) {
-        if (find_vertex(m_max_vd) == vertices_end()) {
-          vertex* v = new vertex(m_max_vd, vp);
-          ++m_max_vd;
-          m_vertices.push_back(v);
-        }
-        return m_max_vd;
+        GRAPH_STAT_ADD(allocations, 1);
+        vertex* v = new vertex(m_max_vd, vp);
+        m_slots.push_back(m_vertices.size());
+        m_vertices.push_back(v);
+        return m_max_vd++;
       }
 
       edge_descriptor insert_edge(vertex_descriptor sd, vertex_descriptor td,
           const EdgeProperty& ep) {
         // this should not return anything if sd or td do not exist
         if (find_edge({sd, td}) == edges_end()) {
-          edge* e = new edge(sd, td, ep);
-          m_edges.push_back(e);
           vertex_iterator si = find_vertex(sd);
           vertex_iterator ti = find_vertex(td);
-          if (si == vertices_end() or ti == vertices_end()){
-            delete e;
+          if (si == vertices_end() or ti == vertices_end())
             return {sd,td};
-          }
+          GRAPH_STAT_ADD(allocations, 1);
+          edge* e = new edge(sd, td, ep);
+          e->m_index = m_edges.size();
+          m_edges.push_back(e);
           (*si)->m_out_edges.push_back(e);
+          if (m_track_in_edges)
+            (*ti)->m_in_edges.push_back(e);
         }
         return {sd,td};
       }
@@ -133,11 +139,19 @@ template<typename VertexProperty, typename EdgeProperty>
         vertex_iterator vi = find_vertex(vd);
         if (vi == vertices_end())
           return;
-        for (vertex_iterator v = vertices_begin(); v != vertices_end(); ++v) {
-          for (adj_edge_iterator e = (*v)->begin(); e != (*v)->end(); ++e) {
-            if ((*e)->target() == vd or (*e)->source() == vd)
-            {
-              edges_to_erase.push_back((*e)->descriptor());
+        if (m_track_in_edges) {
+          for (adj_edge_iterator e = (*vi)->begin(); e != (*vi)->end(); ++e)
+            edges_to_erase.push_back((*e)->descriptor());
+          for (adj_edge_iterator e = (*vi)->in_edges_begin(); e != (*vi)->in_edges_end(); ++e)
+            edges_to_erase.push_back((*e)->descriptor());
+        }
+        else {
+          for (vertex_iterator v = vertices_begin(); v != vertices_end(); ++v) {
+            for (adj_edge_iterator e = (*v)->begin(); e != (*v)->end(); ++e) {
+              if ((*e)->target() == vd or (*e)->source() == vd)
+              {
+                edges_to_erase.push_back((*e)->descriptor());
+              }
             }
           }
         }
@@ -145,9 +159,14 @@ template<typename VertexProperty, typename EdgeProperty>
           erase_edge(ed);
 
         }
-        delete *vi;
-        std::iter_swap(vi, std::prev(vertices_end()));
+        // swap-and-pop, repointing the index entry of the moved vertex
+        size_t s = vi - m_vertices.begin();
+        delete m_vertices[s];
+        m_vertices[s] = m_vertices.back();
         m_vertices.pop_back();
+        m_slots[vd] = npos;
+        if (s != m_vertices.size())
+          m_slots[m_vertices[s]->descriptor()] = s;
       }
 
       void erase_edge(edge_descriptor ed) {
@@ -156,21 +175,100 @@ template<typename VertexProperty, typename EdgeProperty>
           return;
 
         vertex* v = *find_vertex(ed.first);
-        edge_iterator oe = std::find_if(v->begin(), v->end(),
-          [&](const edge* e) {
-          return e->source() == v->descriptor() or e->target() == v->descriptor();
-          }
-        );
-        std::iter_swap(oe, std::prev(v->end()));
-        v->m_out_edges.pop_back();
+        unlink(v->m_out_edges, *e);
+        if (m_track_in_edges)
+          unlink((*find_vertex(ed.second))->m_in_edges, *e);
 
-        delete *e;
-        std::iter_swap(e, std::prev(edges_end()));
+        size_t i = e - m_edges.begin();
+        delete m_edges[i];
+        m_edges[i] = m_edges.back();
         m_edges.pop_back();
+        if (i != m_edges.size())
+          m_edges[i]->m_index = i;
       }
       // end @todo
+
+      ///batch modifiers. insert_vertices adds one vertex per property in
+      ///[first, last) and returns the descriptor of the first; the rest follow
+      ///consecutively. insert_edges takes a forward range of (source, target,
+      ///property) tuples such as edge_triple and returns how many edges were
+      ///added; insert_edges_undirected adds both directions of each. Edges
+      ///are grouped by source so each source's adjacency list is sized once
+      ///and searched for duplicates once, through a sorted copy of its
+      ///targets, instead of once per edge. erase_edges removes the edges
+      ///named by a range of descriptors with one pass over each touched
+      ///adjacency list and returns how many existed.
+      template<typename ForwardIterator>
+      vertex_descriptor insert_vertices(ForwardIterator first, ForwardIterator last) {
+        vertex_descriptor vd = m_max_vd;
+        reserve(std::distance(first, last), 0);
+        for (; first != last; ++first)
+          insert_vertex(*first);
+        return vd;
+      }
+
+      template<typename ForwardIterator>
+      size_t insert_edges(ForwardIterator first, ForwardIterator last) {
+        return insert_edge_batch(first, last, false);
+      }
+
+      template<typename ForwardIterator>
+      size_t insert_edges_undirected(ForwardIterator first, ForwardIterator last) {
+        return insert_edge_batch(first, last, true);
+      }
+
+      template<typename InputIterator>
+      size_t erase_edges(InputIterator first, InputIterator last) {
+        std::vector<edge_descriptor> batch(first, last);
+        std::sort(batch.begin(), batch.end());
+        batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+
+        //unlink from the out-edges, one pass per source
+        std::vector<edge*> doomed;
+        for (size_t i = 0, j; i < batch.size(); i = j) {
+          for (j = i + 1; j < batch.size() and batch[j].first == batch[i].first; ++j) { }
+          size_t s = slot(batch[i].first);
+          if (s == m_vertices.size())
+            continue;
+          adj_edge_storage& out = m_vertices[s]->m_out_edges;
+          auto named = [&](edge* e) {
+            return std::binary_search(batch.begin() + i, batch.begin() + j, e->descriptor());
+          };
+          std::copy_if(out.begin(), out.end(), std::back_inserter(doomed), named);
+          out.erase(std::remove_if(out.begin(), out.end(), named), out.end());
+        }
+
+        //swap-and-pop out of m_edges, marking the removed with npos
+        for (edge* e : doomed) {
+          size_t i = e->m_index;
+          m_edges[i] = m_edges.back();
+          m_edges.pop_back();
+          if (i != m_edges.size())
+            m_edges[i]->m_index = i;
+          e->m_index = npos;
+        }
+
+        //unlink from the in-edges, one pass per target
+        if (m_track_in_edges) {
+          std::sort(doomed.begin(), doomed.end(), [](edge* e, edge* f) {
+              return e->target() < f->target();
+              });
+          for (size_t i = 0; i < doomed.size(); ++i) {
+            if (i > 0 and doomed[i]->target() == doomed[i - 1]->target())
+              continue;
+            adj_edge_storage& in = (*find_vertex(doomed[i]->target()))->m_in_edges;
+            in.erase(std::remove_if(in.begin(), in.end(), [](edge* e) {
+                  return e->m_index == npos;
+                  }), in.end());
+          }
+        }
+        for (edge* e : doomed)
+          delete e;
+        return doomed.size();
+      }
       void clear() {
         m_max_vd = 0;
+        m_slots.clear();
         for(auto v : m_vertices)
           delete v;
         m_vertices.clear();
@@ -179,15 +277,117 @@ template<typename VertexProperty, typename EdgeProperty>
         m_edges.clear();
       }
 
-      template<typename V, typename E>
-        friend std::istream& operator>>(std::istream& is, graph<V, E>& g);
+      ///size every container for a bulk build of num_vertices more vertices
+      ///and num_edges more edges
+      void reserve(size_t num_vertices, size_t num_edges) {
+        m_vertices.reserve(m_vertices.size() + num_vertices);
+        m_slots.reserve(m_slots.size() + num_vertices);
+        m_edges.reserve(m_edges.size() + num_edges);
+      }
+
+      ///size the adjacency lists of vd for out_degree more out-edges and
+      ///in_degree more in-edges
+      void reserve_adjacency(vertex_descriptor vd, size_t out_degree, size_t in_degree) {
+        vertex_iterator vi = find_vertex(vd);
+        if (vi == vertices_end())
+          return;
+        (*vi)->m_out_edges.reserve((*vi)->m_out_edges.size() + out_degree);
+        if (m_track_in_edges)
+          (*vi)->m_in_edges.reserve((*vi)->m_in_edges.size() + in_degree);
+      }
+
+      template<typename V, typename E, size_t N>
+        friend std::istream& operator>>(std::istream& is, graph_vector<V, E, N>& g);
 
-      template<typename V, typename E>
-        friend std::ostream& operator<<(std::ostream& os, const graph<V, E>& g);
+      template<typename V, typename E, size_t N>
+        friend std::ostream& operator<<(std::ostream& os, const graph_vector<V, E, N>& g);
 
     private:
 
+      // Shared body of insert_edges and insert_edges_undirected.
+      template<typename ForwardIterator>
+      size_t insert_edge_batch(ForwardIterator first, ForwardIterator last, bool undirected) {
+        struct pending {
+          vertex_descriptor source, target;
+          ForwardIterator record; // Where the property lives
+        };
+
+        //validate endpoints and group by source, then target
+        std::vector<pending> batch;
+        for (; first != last; ++first) {
+          vertex_descriptor s = std::get<0>(*first), t = std::get<1>(*first);
+          if (slot(s) == m_vertices.size() or slot(t) == m_vertices.size())
+            continue;
+          batch.push_back({s, t, first});
+          if (undirected)
+            batch.push_back({t, s, first});
+        }
+        std::stable_sort(batch.begin(), batch.end(), [](const pending& a, const pending& b) {
+            return a.source < b.source or (a.source == b.source and a.target < b.target);
+            });
+        m_edges.reserve(m_edges.size() + batch.size());
+
+        size_t inserted = 0;
+        std::vector<vertex_descriptor> existing;
+        for (size_t i = 0, j; i < batch.size(); i = j) {
+          for (j = i + 1; j < batch.size() and batch[j].source == batch[i].source; ++j) { }
+          vertex* v = m_vertices[slot(batch[i].source)];
+          existing.clear();
+          for (const edge* e : v->m_out_edges)
+            existing.push_back(e->target());
+          std::sort(existing.begin(), existing.end());
+          v->m_out_edges.reserve(v->m_out_edges.size() + (j - i));
+
+          for (size_t k = i; k < j; ++k) {
+            const pending& p = batch[k];
+            if ((k > i and batch[k - 1].target == p.target) or
+                std::binary_search(existing.begin(), existing.end(), p.target))
+              continue;
+            GRAPH_STAT_ADD(allocations, 1);
+            edge* e = new edge(p.source, p.target, std::get<2>(*p.record));
+            e->m_index = m_edges.size();
+            m_edges.push_back(e);
+            v->m_out_edges.push_back(e);
+            if (m_track_in_edges)
+              m_vertices[slot(p.target)]->m_in_edges.push_back(e);
+            ++inserted;
+          }
+        }
+        return inserted;
+      }
+
+      // Swap-and-pop an edge out of an adjacency list.
+      static void unlink(adj_edge_storage& edges, edge* e) {
+        adj_edge_iterator i = std::find(edges.begin(), edges.end(), e);
+        std::iter_swap(i, std::prev(edges.end()));
+        edges.pop_back();
+      }
+
+      static constexpr size_t npos = size_t(-1);
+
+      // Position of vd in m_vertices, or m_vertices.size() if absent.
+      size_t slot(vertex_descriptor vd) const {
+        if (vd < m_slots.size() and m_slots[vd] != npos)
+          return m_slots[vd];
+        return m_vertices.size();
+      }
+
+      // Position of ed in m_edges, or m_edges.size() if absent.
+      size_t edge_index(edge_descriptor ed) const {
+        GRAPH_STAT_ADD(scan_lookups, 1);
+        size_t s = slot(ed.first);
+        if (s != m_vertices.size())
+          for (const edge* e : m_vertices[s]->m_out_edges) {
+            GRAPH_STAT_ADD(scan_steps, 1);
+            if (e->target() == ed.second)
+              return e->m_index;
+          }
+        return m_edges.size();
+      }
+
       size_t m_max_vd; // Id generator for next vertex to be inserted
+      bool m_track_in_edges; // Whether vertices keep their in-edges
+      std::vector<size_t> m_slots; // Descriptor -> position in m_vertices, npos once erased
       vertex_storage m_vertices;  // List of all vertices in the graph
       edge_storage m_edges;    // List of  all edges in the graph
 
@@ -207,6 +407,12 @@ template<typename VertexProperty, typename EdgeProperty>
           adj_edge_iterator end() {return m_out_edges.end();}
           const_adj_edge_iterator cend() const {return m_out_edges.cend();}
 
+          //in-edge iterators, empty unless the graph tracks in-edges
+          adj_edge_iterator in_edges_begin() {return m_in_edges.begin();}
+          const_adj_edge_iterator in_edges_cbegin() const {return m_in_edges.cbegin();}
+          adj_edge_iterator in_edges_end() {return m_in_edges.end();}
+          const_adj_edge_iterator in_edges_cend() const {return m_in_edges.cend();}
+
           //accessors
           const vertex_descriptor descriptor() const {return m_descriptor;}
           VertexProperty& property() {return m_property;}
@@ -216,6 +422,7 @@ template<typename VertexProperty, typename EdgeProperty>
           vertex_descriptor m_descriptor; // Unique id assigned during insertion
           VertexProperty m_property;      // Label or weight passed during insertion
           adj_edge_storage m_out_edges;   // Outgoing edges
+          adj_edge_storage m_in_edges;    // Incoming edges, if tracked
   
           friend class graph_vector;
       };
@@ -239,23 +446,28 @@ template<typename VertexProperty, typename EdgeProperty>
           vertex_descriptor m_source; // Descriptor of source vertex
           vertex_descriptor m_target;  // Descriptor of target vertex
           EdgeProperty m_property;    // Label or weight on the edge
+          size_t m_index;             // Position in m_edges
+
+          friend class graph_vector;
       };
 
   };
 
-template<typename V, typename E>
-  std::istream& operator>>(std::istream& is, graph_vector<V, E>& g) {
+template<typename V, typename E, size_t N>
+  constexpr size_t graph_vector<V, E, N>::npos;
+
+template<typename V, typename E, size_t N>
+  std::istream& operator>>(std::istream& is, graph_vector<V, E, N>& g) {
     size_t num_verts, num_edges;
     is >> num_verts >> num_edges;
-    g.m_vertices.reserve(num_verts);
-    g.m_vertices.reserve(num_edges);
+    g.reserve(num_verts, num_edges);
     for(size_t i = 0; i < num_verts; ++i) {
       V v;
       is >> v;
       g.insert_vertex(v);
     }
     for(size_t i = 0; i < num_edges; ++i) {
-      typename graph<V, E>::vertex_descriptor s, t;
+      typename graph_vector<V, E>::vertex_descriptor s, t;
       E e;
       is >> s >> t >> e;
       g.insert_edge(s, t, e);
@@ -263,8 +475,8 @@ template<typename V, typename E>
     return is;
   }
 
-template<typename V, typename E>
-  std::ostream& operator<<(std::ostream& os, const graph_vector<V, E>& g) {
+template<typename V, typename E, size_t N>
+  std::ostream& operator<<(std::ostream& os, const graph_vector<V, E, N>& g) {
     os << g.num_vertices() << " " << g.num_edges() << std::endl;
     for(auto i = g.vertices_cbegin(); i != g.vertices_cend(); ++i)
       os << (*i)->property() << std::endl;
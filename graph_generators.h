@@ -0,0 +1,299 @@
+#ifndef _GRAPH_GENERATORS_H_
+#define _GRAPH_GENERATORS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+#include "thread_team.h"
+
+// Synthetic graph generators shared by timing.cpp and benchmark.cpp. They work
+// on any graph type with the batch modifiers insert_vertices/insert_edges.
+// Edges are generated into a buffer first and handed to the graph in one
+// batch.
+//
+// The initialize_* generators draw from rand(), so seeding with srand() makes
+// a build reproducible. The generate_* generators are for large graphs: they
+// fill the edge buffer in parallel on a thread_team, each fixed-size chunk of
+// edges drawing from its own rng_stream keyed by (seed, chunk), so the graph
+// depends on the seed alone and not on the number of threads.
+
+/// @brief add vertices with properties 0..n-1, returning the first descriptor
+template <typename graph_id>
+size_t insert_numbered_vertices(graph_id &g, size_t n)
+{
+    std::vector<size_t> properties(n);
+    std::iota(properties.begin(), properties.end(), 0);
+    return g.insert_vertices(properties.begin(), properties.end());
+}
+
+/// @brief Deterministic random stream (splitmix64). Streams with the same seed
+///        and different stream numbers are independent.
+class rng_stream
+{
+public:
+    rng_stream(uint64_t seed, uint64_t stream) : m_state(mix(seed) ^ mix(stream + 0x632BE59BD9B4E019ull)) {}
+
+    uint64_t next()
+    {
+        m_state += 0x9E3779B97F4A7C15ull;
+        return mix(m_state);
+    }
+
+    /// @brief uniform in [0, 1)
+    double uniform() { return (next() >> 11) * (1.0 / (uint64_t(1) << 53)); }
+
+    /// @brief uniform in [0, n)
+    uint64_t below(uint64_t n) { return uint64_t((unsigned __int128)next() * n >> 64); }
+
+private:
+    static uint64_t mix(uint64_t z)
+    {
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    uint64_t m_state;
+};
+
+/// @brief Fill a buffer of m edges in parallel, edge i being gen(rng, i) with
+///        rng the stream of i's chunk. Edges whose ends are equal are dropped,
+///        so gen can return (v, v, w) for a slot with no edge.
+template <typename edge_triple, typename Generate>
+std::vector<edge_triple> generate_edges(size_t m, thread_team &team, uint64_t seed, Generate gen)
+{
+    const size_t chunk = size_t(1) << 14;
+    std::vector<edge_triple> edges(m);
+    team.parallel_for(0, (m + chunk - 1) / chunk, 1, [&](size_t c, size_t) {
+        rng_stream rng(seed, c);
+        for (size_t i = c * chunk, e = std::min(m, i + chunk); i < e; ++i)
+            edges[i] = gen(rng, i);
+    });
+    edges.erase(std::remove_if(edges.begin(), edges.end(),
+                               [](const edge_triple &e) { return std::get<0>(e) == std::get<1>(e); }),
+                edges.end());
+    return edges;
+}
+
+/// @brief Team shared by the size-only generators below, one thread per core
+inline thread_team &generator_team()
+{
+    static thread_team team;
+    return team;
+}
+
+/// @brief create a complete graph of size n
+template <typename graph_id>
+void initialize_complete_graph(graph_id &g, size_t n)
+{
+    // add vertices
+    size_t base = insert_numbered_vertices(g, n);
+    std::vector<typename graph_id::edge_triple> edges;
+
+    // add edges between the consecutive descriptors insert_vertices handed out
+    edges.reserve(n ? n * (n - 1) : 0);
+    for (size_t s = base; s < base + n; ++s)
+        for (size_t t = base; t < base + n; ++t)
+            if (s != t)
+                edges.emplace_back(s, t, double(rand()) / RAND_MAX);
+    g.insert_edges(edges.begin(), edges.end());
+}
+
+/// @brief create a mesh of size n
+template <typename graph_id>
+void initialize_mesh_graph(graph_id &g, size_t n)
+{
+    // make n a square number
+    size_t rootn = sqrt(n);
+    n = rootn * rootn;
+
+    // add vertices
+    insert_numbered_vertices(g, n);
+    std::vector<typename graph_id::edge_triple> edges;
+
+    // add edges
+    for (size_t i = 0; i < n; ++i)
+    {
+        size_t x = i + 1;
+        size_t y = i + rootn;
+
+        if (x % rootn != 0)
+            edges.emplace_back(i, x, double(rand()) / RAND_MAX);
+
+        if (y < n)
+            edges.emplace_back(i, y, double(rand()) / RAND_MAX);
+    }
+    g.insert_edges_undirected(edges.begin(), edges.end());
+}
+
+/// @brief create a connected random graph of size n
+template <typename graph_id>
+void initialize_random_graph(graph_id &g, size_t n)
+{
+    // add vertices
+    insert_numbered_vertices(g, n);
+    std::vector<typename graph_id::edge_triple> edges;
+
+    // add edges for connectivity
+    for (size_t i = 0; i < n - 1; ++i)
+        edges.emplace_back(i, i + 1, double(rand()) / RAND_MAX);
+
+    size_t num_edges = n * sqrt(n) / 2;
+    for (size_t i = 0; i < num_edges; ++i)
+    {
+        size_t s = rand() % n;
+        size_t t = rand() % n;
+        if (s != t)
+            edges.emplace_back(s, t, double(rand()) / RAND_MAX);
+        else
+            --i;
+    }
+    g.insert_edges_undirected(edges.begin(), edges.end());
+}
+
+/// @brief R-MAT / Kronecker graph in the style of Graph500: 2^scale vertices
+///        and edge_factor * 2^scale undirected edges. Each edge picks one
+///        quadrant of the adjacency matrix per bit of its endpoints, with
+///        probabilities a, b, c and 1 - a - b - c, which gives the skewed,
+///        power-law degrees of real networks. Vertex labels are then permuted
+///        so that degree does not follow descriptor order. Self-loops and
+///        repeated edges are dropped, so a few edges fewer result.
+template <typename graph_id>
+void generate_rmat_graph(graph_id &g, size_t scale, size_t edge_factor, thread_team &team, uint64_t seed,
+                         double a = 0.57, double b = 0.19, double c = 0.19)
+{
+    typedef typename graph_id::edge_triple edge_triple;
+    size_t n = size_t(1) << scale;
+    size_t base = insert_numbered_vertices(g, n);
+
+    std::vector<size_t> label(n);
+    std::iota(label.begin(), label.end(), base);
+    rng_stream shuffle(seed, ~uint64_t(0));
+    for (size_t i = n - 1; i > 0; --i)
+        std::swap(label[i], label[shuffle.below(i + 1)]);
+
+    // quadrant thresholds in 32-bit fixed point, so one draw serves two bits
+    const double unit = 4294967296.0;
+    const uint64_t ta = a * unit, tab = (a + b) * unit, tabc = (a + b + c) * unit;
+    std::vector<edge_triple> edges = generate_edges<edge_triple>(
+        edge_factor * n, team, seed, [&](rng_stream &rng, size_t) {
+            size_t s = 0, t = 0;
+            uint64_t bits = 0;
+            for (size_t bit = 0; bit < scale; ++bit)
+            {
+                if (bit % 2 == 0)
+                    bits = rng.next();
+                uint64_t r = bits & 0xFFFFFFFFu;
+                bits >>= 32;
+                s = 2 * s + (r >= tab);
+                t = 2 * t + (((r >= ta) & (r < tab)) | (r >= tabc));
+            }
+            return edge_triple(label[s], label[t], rng.uniform());
+        });
+    g.insert_edges_undirected(edges.begin(), edges.end());
+}
+
+/// @brief Erdos-Renyi G(n, m): m undirected edges between uniformly chosen
+///        distinct vertices (repeats dropped)
+template <typename graph_id>
+void generate_erdos_renyi_graph(graph_id &g, size_t n, size_t m, thread_team &team, uint64_t seed)
+{
+    typedef typename graph_id::edge_triple edge_triple;
+    size_t base = insert_numbered_vertices(g, n);
+    std::vector<edge_triple> edges = generate_edges<edge_triple>(
+        n > 1 ? m : 0, team, seed, [&](rng_stream &rng, size_t) {
+            size_t s = rng.below(n);
+            size_t t = rng.below(n - 1);
+            t += t >= s;
+            return edge_triple(base + s, base + t, rng.uniform());
+        });
+    g.insert_edges_undirected(edges.begin(), edges.end());
+}
+
+/// @brief nx by ny by nz grid (nz = 1 for 2D) with undirected edges between
+///        axis neighbors
+template <typename graph_id>
+void generate_grid_graph(graph_id &g, size_t nx, size_t ny, size_t nz, thread_team &team, uint64_t seed)
+{
+    typedef typename graph_id::edge_triple edge_triple;
+    size_t n = nx * ny * nz;
+    size_t base = insert_numbered_vertices(g, n);
+    // slot 3v + d is v's edge to its next neighbor along axis d, if any
+    std::vector<edge_triple> edges = generate_edges<edge_triple>(
+        3 * n, team, seed, [&](rng_stream &rng, size_t i) {
+            size_t v = i / 3, d = i % 3;
+            size_t coordinate[3] = {v % nx, v / nx % ny, v / (nx * ny)};
+            size_t extent[3] = {nx, ny, nz};
+            size_t stride[3] = {1, nx, nx * ny};
+            double w = rng.uniform();
+            if (coordinate[d] + 1 >= extent[d])
+                return edge_triple(base + v, base + v, w);
+            return edge_triple(base + v, base + v + stride[d], w);
+        });
+    g.insert_edges_undirected(edges.begin(), edges.end());
+}
+
+/// @brief Chung-Lu graph with a power-law degree distribution: vertex i has
+///        weight (i + 1)^(-1 / (exponent - 1)) and each of the m undirected
+///        edges joins two vertices drawn in proportion to weight, so expected
+///        degrees follow a power law with the given exponent (> 2)
+template <typename graph_id>
+void generate_power_law_graph(graph_id &g, size_t n, size_t m, double exponent, thread_team &team,
+                              uint64_t seed)
+{
+    typedef typename graph_id::edge_triple edge_triple;
+    size_t base = insert_numbered_vertices(g, n);
+    std::vector<double> cumulative(n);
+    double total = 0;
+    for (size_t i = 0; i < n; ++i)
+        cumulative[i] = total += std::pow(double(i + 1), -1 / (exponent - 1));
+    auto draw = [&](rng_stream &rng) {
+        size_t i = std::upper_bound(cumulative.begin(), cumulative.end(), rng.uniform() * total) -
+                   cumulative.begin();
+        return base + std::min(i, n - 1);
+    };
+    std::vector<edge_triple> edges = generate_edges<edge_triple>(
+        n ? m : 0, team, seed, [&](rng_stream &rng, size_t) {
+            size_t s = draw(rng);
+            size_t t = draw(rng);
+            return edge_triple(s, t, rng.uniform());
+        });
+    g.insert_edges_undirected(edges.begin(), edges.end());
+}
+
+/// @brief Size-only forms of the generators above for timing.cpp and
+///        benchmark.cpp: about n vertices, seeded from rand()
+template <typename graph_id>
+void initialize_rmat_graph(graph_id &g, size_t n)
+{
+    size_t scale = 1;
+    while ((size_t(1) << scale) < n)
+        ++scale;
+    generate_rmat_graph(g, scale, 16, generator_team(), rand());
+}
+
+template <typename graph_id>
+void initialize_erdos_renyi_graph(graph_id &g, size_t n)
+{
+    generate_erdos_renyi_graph(g, n, 8 * n, generator_team(), rand());
+}
+
+template <typename graph_id>
+void initialize_grid3d_graph(graph_id &g, size_t n)
+{
+    size_t side = std::max<size_t>(1, std::cbrt(double(n)));
+    generate_grid_graph(g, side, side, side, generator_team(), rand());
+}
+
+template <typename graph_id>
+void initialize_power_law_graph(graph_id &g, size_t n)
+{
+    generate_power_law_graph(g, n, 8 * n, 2.5, generator_team(), rand());
+}
+
+#endif
@@ -0,0 +1,300 @@
+#ifndef _GRAPH_IO_H_
+#define _GRAPH_IO_H_
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// A read-only view of a whole file, memory-mapped when possible and read into
+/// a buffer otherwise (pipes, special files, empty files). advice is passed to
+/// madvise for the mapping: MADV_SEQUENTIAL for one front-to-back parse,
+/// MADV_NORMAL or MADV_RANDOM for data that is traversed in place.
+////////////////////////////////////////////////////////////////////////////////
+class mapped_file {
+  public:
+    explicit mapped_file(const std::string& path, int advice = MADV_SEQUENTIAL) :
+      m_data(nullptr), m_size(0), m_mapped(false), m_open(false) {
+      int fd = ::open(path.c_str(), O_RDONLY);
+      if(fd < 0)
+        return;
+      struct stat st;
+      if(::fstat(fd, &st) == 0 and S_ISREG(st.st_mode) and st.st_size > 0) {
+        void* p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p != MAP_FAILED) {
+          ::madvise(p, st.st_size, advice);
+          m_data = static_cast<const char*>(p);
+          m_size = st.st_size;
+          m_mapped = true;
+        }
+      }
+      if(!m_mapped) {
+        char buf[1 << 16];
+        for(ssize_t n; (n = ::read(fd, buf, sizeof(buf))) != 0; ) {
+          if(n < 0 and errno == EINTR)
+            continue;
+          if(n < 0)
+            break;
+          m_buffer.insert(m_buffer.end(), buf, buf + n);
+        }
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+      }
+      m_open = true;
+      ::close(fd);
+    }
+
+    ~mapped_file() {
+      if(m_mapped)
+        ::munmap(const_cast<char*>(m_data), m_size);
+    }
+
+    mapped_file(const mapped_file&) = delete;             ///< Copy is disabled.
+    mapped_file& operator=(const mapped_file&) = delete;  ///< Copy is disabled.
+
+    bool is_open() const {return m_open;}
+    const char* data() const {return m_data;}
+    size_t size() const {return m_size;}
+
+  private:
+    const char* m_data;         //< First byte of the contents
+    size_t m_size;              //< Length of the contents
+    bool m_mapped;              //< Whether m_data is an mmap to release
+    bool m_open;                //< Whether the file could be opened
+    std::vector<char> m_buffer; //< Contents when mapping was not possible
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// Whitespace-separated number scanner over a character range. Integers are
+/// accumulated digit by digit; floating-point values take the exact fast path
+/// (at most 15 significant digits and a power of ten up to 1e22, so one
+/// correctly rounded multiply or divide) and fall back to strtod otherwise.
+/// Any other type is read through an istringstream over its token.
+////////////////////////////////////////////////////////////////////////////////
+class text_scanner {
+  public:
+    text_scanner(const char* first, const char* last) : m_pos(first), m_end(last) { }
+
+    ///@brief Read the next value; false on end of input or a malformed token.
+    template<typename T>
+    bool next(T& value) {
+      skip_space();
+      if(m_pos == m_end)
+        return false;
+      return parse(value, tag<T>());
+    }
+
+    ///@brief Number of characters not yet read.
+    size_t remaining() const {return m_end - m_pos;}
+
+  private:
+    template<typename T> struct tag { };
+
+    static bool is_space(char c) {
+      return c == ' ' or c == '\n' or c == '\t' or c == '\r' or c == '\f' or c == '\v';
+    }
+
+    void skip_space() {
+      while(m_pos != m_end and is_space(*m_pos))
+        ++m_pos;
+    }
+
+    const char* token_end() const {
+      const char* p = m_pos;
+      while(p != m_end and !is_space(*p))
+        ++p;
+      return p;
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value, bool>::type
+    parse(T& value, tag<T>) {
+      bool negative = false;
+      if(*m_pos == '-' or *m_pos == '+') {
+        negative = *m_pos == '-';
+        if(negative and std::is_unsigned<T>::value)
+          return false;
+        ++m_pos;
+      }
+      const char* first = m_pos;
+      uint64_t v = 0;
+      bool overflow = false;
+      while(m_pos != m_end and unsigned(*m_pos - '0') < 10) {
+        unsigned d = unsigned(*m_pos++ - '0');
+        overflow = overflow or v > (std::numeric_limits<uint64_t>::max() - d) / 10;
+        v = v * 10 + d;
+      }
+      if(m_pos == first or (m_pos != m_end and !is_space(*m_pos)))
+        return false;
+      //out of range for T, e.g. a descriptor that would wrap to a valid one
+      uint64_t limit = uint64_t(std::numeric_limits<T>::max()) + uint64_t(negative);
+      if(overflow or v > limit)
+        return false;
+      value = negative ? T(0 - v) : T(v);
+      return true;
+    }
+
+    template<typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, bool>::type
+    parse(T& value, tag<T>) {
+      const char* start = m_pos;
+      bool negative = false;
+      if(*m_pos == '-' or *m_pos == '+')
+        negative = *m_pos++ == '-';
+
+      uint64_t mantissa = 0;
+      int digits = 0, exponent = 0;
+      bool any = false;
+      for(; m_pos != m_end and unsigned(*m_pos - '0') < 10; ++m_pos, any = true) {
+        if(digits < 19) {
+          mantissa = mantissa * 10 + unsigned(*m_pos - '0');
+          digits += mantissa != 0;
+        }
+        else
+          ++exponent;
+      }
+      if(m_pos != m_end and *m_pos == '.') {
+        ++m_pos;
+        for(; m_pos != m_end and unsigned(*m_pos - '0') < 10; ++m_pos, any = true) {
+          if(digits < 19) {
+            mantissa = mantissa * 10 + unsigned(*m_pos - '0');
+            digits += mantissa != 0;
+            --exponent;
+          }
+        }
+      }
+      if(any and m_pos != m_end and (*m_pos == 'e' or *m_pos == 'E')) {
+        ++m_pos;
+        bool negative_exponent = false;
+        if(m_pos != m_end and (*m_pos == '-' or *m_pos == '+'))
+          negative_exponent = *m_pos++ == '-';
+        int e = 0;
+        const char* first = m_pos;
+        while(m_pos != m_end and unsigned(*m_pos - '0') < 10 and e < 100000)
+          e = e * 10 + (*m_pos++ - '0');
+        if(m_pos == first)
+          any = false;
+        exponent += negative_exponent ? -e : e;
+      }
+      if(!any or (m_pos != m_end and !is_space(*m_pos))) {
+        // inf, nan, hex floats and malformed tokens
+        m_pos = start;
+        return slow_float(value);
+      }
+
+      static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+        1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+        1e20, 1e21, 1e22};
+      if(digits <= 15 and exponent >= -22 and exponent <= 22) {
+        double d = double(mantissa);
+        d = exponent < 0 ? d / powers[-exponent] : d * powers[exponent];
+        value = T(negative ? -d : d);
+        return true;
+      }
+      m_pos = start;
+      return slow_float(value);
+    }
+
+    template<typename T>
+    bool slow_float(T& value) {
+      const char* last = token_end();
+      std::string token(m_pos, last);
+      char* stop;
+      double d = std::strtod(token.c_str(), &stop);
+      if(stop != token.c_str() + token.size() or token.empty())
+        return false;
+      m_pos = last;
+      value = T(d);
+      return true;
+    }
+
+    template<typename T>
+    typename std::enable_if<!std::is_arithmetic<T>::value, bool>::type
+    parse(T& value, tag<T>) {
+      const char* last = token_end();
+      std::istringstream is(std::string(m_pos, last));
+      m_pos = last;
+      return bool(is >> value);
+    }
+
+    const char* m_pos; //< Next unread character
+    const char* m_end; //< End of the input
+};
+
+
+///@brief Load a graph in the text format of operator<< ("football.g"
+///       style: vertex and edge counts, one property per vertex, then
+///       "source target property" per edge) from a file. The file is
+///       memory-mapped and parsed in one pass into flat arrays; the graph is
+///       then built with every container sized once from the counts and
+///       per-vertex degrees. Vertices get descriptors in file order on top of
+///       whatever g already holds. Returns false if the file cannot be read or
+///       is malformed, in which case g is left unchanged.
+template<typename Graph>
+  bool load_graph(const std::string& path, Graph& g) {
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    typedef typename std::decay<decltype(
+        (*std::declval<const Graph&>().vertices_cbegin())->property())>::type VertexProperty;
+    typedef typename std::decay<decltype(
+        (*std::declval<const Graph&>().edges_cbegin())->property())>::type EdgeProperty;
+
+    mapped_file file(path);
+    if(!file.is_open())
+      return false;
+    text_scanner in(file.data(), file.data() + file.size());
+
+    size_t num_verts, num_edges;
+    if(!in.next(num_verts) or !in.next(num_edges))
+      return false;
+
+    //every value is at least one character and a separator, so counts the
+    //rest of the file cannot hold are malformed rather than allocated
+    size_t limit = in.remaining() / 2 + 1;
+    if(num_verts > limit or num_edges > limit or num_verts + 3 * num_edges > limit)
+      return false;
+
+    std::vector<VertexProperty> vertices(num_verts);
+    for(auto& v : vertices)
+      if(!in.next(v))
+        return false;
+
+    std::vector<vertex_descriptor> sources(num_edges), targets(num_edges);
+    std::vector<EdgeProperty> properties(num_edges);
+    std::vector<size_t> out_degree(num_verts, 0), in_degree(num_verts, 0);
+    for(size_t i = 0; i < num_edges; ++i) {
+      if(!in.next(sources[i]) or !in.next(targets[i]) or !in.next(properties[i]))
+        return false;
+      if(sources[i] >= num_verts or targets[i] >= num_verts)
+        return false;
+      ++out_degree[sources[i]];
+      ++in_degree[targets[i]];
+    }
+
+    //build, sizing every container once
+    g.reserve(num_verts, num_edges);
+    std::vector<vertex_descriptor> descriptors(num_verts);
+    for(size_t i = 0; i < num_verts; ++i) {
+      descriptors[i] = g.insert_vertex(vertices[i]);
+      g.reserve_adjacency(descriptors[i], out_degree[i], in_degree[i]);
+    }
+    for(size_t i = 0; i < num_edges; ++i)
+      g.insert_edge(descriptors[sources[i]], descriptors[targets[i]], properties[i]);
+    return true;
+  }
+
+
+#endif
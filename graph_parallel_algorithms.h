@@ -0,0 +1,475 @@
+#ifndef _GRAPH_PARALLEL_ALGORITHMS_H_
+#define _GRAPH_PARALLEL_ALGORITHMS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <map>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "graph_algorithms.h"
+#include "thread_team.h"
+
+
+// Multi-threaded counterparts of the searches in graph_algorithms.h. They take
+// the same Graph and ParentMap parameters plus a thread_team to run on. The
+// graph is only read, concurrently; the ParentMap is filled by the calling
+// thread once the parallel work is done, so any associative container works.
+
+
+///@brief Level-synchronous parallel breadth-first search. Each level's
+///       frontier is split across the team; a thread claims a vertex by
+///       compare-and-swap on its slot of a descriptor-indexed parent array and
+///       appends it to its own next-frontier buffer. The buffers are
+///       concatenated at prefix-sum offsets without a lock. Levels smaller than
+///       sequential_cutoff are expanded by the calling thread alone. Fills p
+///       like breadth_first_search (trees may differ, levels do not).
+template<typename Graph, typename ParentMap>
+  void parallel_breadth_first_search(const Graph& g, ParentMap& p,
+      thread_team& team, size_t sequential_cutoff = 1024) {
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    typedef typename Graph::const_vertex_iterator vertex_iterator;
+    typedef typename Graph::const_adj_edge_iterator adj_edge_iterator;
+    const size_t unvisited = size_t(-1);
+
+    //setup: descriptor-indexed vertex table and parent array
+    size_t bound = vertex_descriptor_bound(g);
+    std::vector<vertex_iterator> table(bound, g.vertices_cend());
+    std::vector<vertex_descriptor> order;
+    order.reserve(g.num_vertices());
+    for(vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
+      table[(*vi)->descriptor()] = vi;
+      order.push_back((*vi)->descriptor());
+    }
+    std::vector<std::atomic<size_t>> parent(bound);
+    team.parallel_for(0, bound, 4096, [&](size_t i, size_t) {
+        parent[i].store(unvisited, std::memory_order_relaxed);
+        });
+
+    std::vector<std::vector<vertex_descriptor>> local(team.size());
+    std::vector<size_t> offsets(team.size() + 1);
+    std::vector<vertex_descriptor> frontier, next;
+
+    // Claim every unvisited target of u, appending claims to out.
+    auto expand = [&](vertex_descriptor u, std::vector<vertex_descriptor>& out) {
+      auto& v = *table[u];
+      for(adj_edge_iterator aei = v->begin(); aei != v->end(); ++aei) {
+        vertex_descriptor t = (*aei)->target();
+        size_t expected = unvisited;
+        if(parent[t].load(std::memory_order_relaxed) == unvisited and
+            parent[t].compare_exchange_strong(expected, u, std::memory_order_relaxed))
+          out.push_back(t);
+      }
+    };
+
+    //for each CC
+    for(vertex_descriptor root : order) {
+      if(parent[root].load(std::memory_order_relaxed) != unvisited)
+        continue;
+      parent[root].store(root, std::memory_order_relaxed);
+      frontier.assign(1, root);
+
+      while(!frontier.empty()) {
+        if(frontier.size() < sequential_cutoff) {
+          next.clear();
+          for(vertex_descriptor u : frontier)
+            expand(u, next);
+        }
+        else {
+          team.run([&](size_t tid) {local[tid].clear();});
+          team.parallel_for(0, frontier.size(), 64, [&](size_t i, size_t tid) {
+              expand(frontier[i], local[tid]);
+              });
+          for(size_t tid = 0; tid < team.size(); ++tid)
+            offsets[tid + 1] = offsets[tid] + local[tid].size();
+          next.resize(offsets.back());
+          team.run([&](size_t tid) {
+              std::copy(local[tid].begin(), local[tid].end(), next.begin() + offsets[tid]);
+              });
+        }
+        frontier.swap(next);
+      }
+    }
+
+    reset_property_map(p, g);
+    for(vertex_descriptor vd : order) {
+      size_t u = parent[vd].load(std::memory_order_relaxed);
+      p[vd] = u == vd ? vertex_descriptor(-1) : u;
+    }
+  }
+
+
+///@brief Parallel spanning forest for the depth-first search use case: one
+///       tree per connected component, edges taken as undirected (weakly
+///       connected components for directed graphs). Threads hook component
+///       roots together with a lock-free union-find, always linking the larger
+///       root under the smaller; every successful hook is a forest edge. The
+///       forest is then oriented away from each component's smallest
+///       descriptor, trees in parallel. Tree shape differs from
+///       depth_first_search; roots map to -1 as usual.
+template<typename Graph, typename ParentMap>
+  void parallel_spanning_forest(const Graph& g, ParentMap& p, thread_team& team) {
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    typedef typename Graph::const_vertex_iterator vertex_iterator;
+    typedef typename Graph::const_adj_edge_iterator adj_edge_iterator;
+    typedef std::pair<vertex_descriptor, vertex_descriptor> tree_edge;
+
+    //setup
+    size_t bound = vertex_descriptor_bound(g);
+    std::vector<vertex_iterator> table;
+    table.reserve(g.num_vertices());
+    for(vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi)
+      table.push_back(vi);
+    std::vector<std::atomic<size_t>> comp(bound);
+    team.parallel_for(0, bound, 4096, [&](size_t i, size_t) {
+        comp[i].store(i, std::memory_order_relaxed);
+        });
+
+    // Root of x, halving the path on the way.
+    auto find = [&](size_t x) {
+      for(;;) {
+        size_t px = comp[x].load(std::memory_order_relaxed);
+        if(px == x)
+          return x;
+        size_t gx = comp[px].load(std::memory_order_relaxed);
+        if(gx != px)
+          comp[x].compare_exchange_weak(px, gx, std::memory_order_relaxed);
+        x = gx;
+      }
+    };
+
+    //hook components, recording the edge behind every successful link
+    std::vector<std::vector<tree_edge>> local(team.size());
+    team.parallel_for(0, table.size(), 64, [&](size_t i, size_t tid) {
+        auto& v = *table[i];
+        vertex_descriptor s = v->descriptor();
+        for(adj_edge_iterator aei = v->begin(); aei != v->end(); ++aei) {
+          vertex_descriptor t = (*aei)->target();
+          for(;;) {
+            size_t rs = find(s), rt = find(t);
+            if(rs == rt)
+              break;
+            size_t hi = std::max(rs, rt), lo = std::min(rs, rt);
+            if(comp[hi].compare_exchange_strong(hi, lo, std::memory_order_relaxed)) {
+              local[tid].emplace_back(s, t);
+              break;
+            }
+          }
+        }
+        });
+
+    //forest adjacency in CSR form
+    std::vector<size_t> offsets(bound + 1, 0);
+    for(const auto& l : local)
+      for(const tree_edge& e : l) {
+        ++offsets[e.first + 1];
+        ++offsets[e.second + 1];
+      }
+    for(size_t i = 0; i < bound; ++i)
+      offsets[i + 1] += offsets[i];
+    std::vector<vertex_descriptor> adjacent(offsets.back());
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    for(const auto& l : local)
+      for(const tree_edge& e : l) {
+        adjacent[fill[e.first]++] = e.second;
+        adjacent[fill[e.second]++] = e.first;
+      }
+
+    //orient each tree from its root (comp[r] == r is the smallest descriptor)
+    std::vector<vertex_descriptor> parent(bound, vertex_descriptor(-1));
+    std::vector<std::vector<vertex_descriptor>> stacks(team.size());
+    team.parallel_for(0, table.size(), 64, [&](size_t i, size_t tid) {
+        vertex_descriptor r = (*table[i])->descriptor();
+        if(comp[r].load(std::memory_order_relaxed) != r)
+          return;
+        auto& s = stacks[tid];
+        s.assign(1, r);
+        while(!s.empty()) {
+          vertex_descriptor u = s.back();
+          s.pop_back();
+          for(size_t j = offsets[u]; j < offsets[u + 1]; ++j) {
+            vertex_descriptor t = adjacent[j];
+            if(t != parent[u]) {
+              parent[t] = u;
+              s.push_back(t);
+            }
+          }
+        }
+        });
+
+    reset_property_map(p, g);
+    for(vertex_iterator vi : table) {
+      vertex_descriptor vd = (*vi)->descriptor();
+      p[vd] = parent[vd];
+    }
+  }
+
+
+///@brief Parallel delta-stepping single-source shortest paths (Meyer and
+///       Sanders) over non-negative edge properties. Tentative distances are
+///       grouped in buckets of width delta. The current bucket is drained in
+///       phases: its vertices are split across the team and relax their light
+///       edges (weight <= delta), which may refill the same bucket; once it
+///       stays empty, the heavy edges of every vertex it held are relaxed
+///       once. Each vertex's distance and parent are updated together under
+///       a per-vertex spinlock, and threads queue improved vertices in their
+///       own buckets, skipping entries made stale by a later improvement. A
+///       delta of 0 picks the largest weight over the average out-degree.
+///       Fills p and d like dijkstra_shortest_paths (the distances are equal;
+///       among equally short paths the parent may differ).
+template<typename Graph, typename ParentMap, typename DistanceMap>
+  void parallel_delta_stepping(const Graph& g, typename Graph::vertex_descriptor source,
+      ParentMap& p, DistanceMap& d, thread_team& team, double delta = 0) {
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    typedef typename Graph::const_vertex_iterator vertex_iterator;
+    typedef typename Graph::const_adj_edge_iterator adj_edge_iterator;
+    typedef typename DistanceMap::mapped_type distance;
+    typedef std::vector<vertex_descriptor> bucket;
+    const size_t unsettled = size_t(-1);
+
+    //setup: descriptor-indexed vertex table, and delta if not given
+    size_t bound = vertex_descriptor_bound(g);
+    std::vector<vertex_iterator> table(bound, g.vertices_cend());
+    std::vector<vertex_descriptor> order;
+    order.reserve(g.num_vertices());
+    for(vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
+      table[(*vi)->descriptor()] = vi;
+      order.push_back((*vi)->descriptor());
+    }
+    reset_property_map(p, g);
+    reset_property_map(d, g);
+    for(vertex_descriptor vd : order)
+      p[vd] = -1;
+    if(source >= bound or table[source] == g.vertices_cend())
+      return;
+    if(delta <= 0) {
+      double heaviest = 0;
+      for(vertex_iterator vi : table)
+        if(vi != g.vertices_cend())
+          for(adj_edge_iterator aei = (*vi)->begin(); aei != (*vi)->end(); ++aei)
+            heaviest = std::max(heaviest, double((*aei)->property()));
+      double degree = g.num_vertices() ? double(g.num_edges()) / g.num_vertices() : 1;
+      delta = heaviest > 0 ? heaviest / std::max(1.0, degree) : 1;
+    }
+
+    std::vector<std::atomic<distance>> dist(bound);
+    std::vector<vertex_descriptor> parent(bound, vertex_descriptor(-1));
+    std::vector<std::atomic<bool>> locked(bound);
+    std::vector<std::atomic<size_t>> settled_in(bound);
+    team.parallel_for(0, bound, 4096, [&](size_t i, size_t) {
+        dist[i].store(std::numeric_limits<distance>::max(), std::memory_order_relaxed);
+        locked[i].store(false, std::memory_order_relaxed);
+        settled_in[i].store(unsettled, std::memory_order_relaxed);
+        });
+    dist[source].store(distance(), std::memory_order_relaxed);
+
+    // Per-thread buckets keyed by distance / delta. Only non-empty buckets
+    // are kept, so a small delta or heavy weights leave no run of empty ones.
+    std::vector<std::map<size_t, bucket>> buckets(team.size());
+    std::vector<bucket> settled(team.size());
+    buckets[0][0].push_back(source);
+
+    // Lower t's distance to du + w, queueing t in the matching bucket.
+    auto relax = [&](vertex_descriptor u, distance du, vertex_descriptor t, distance w, size_t tid) {
+      distance nd = du + w;
+      if(!(nd < dist[t].load(std::memory_order_relaxed)))
+        return;
+      while(locked[t].exchange(true, std::memory_order_acquire)) { }
+      bool better = nd < dist[t].load(std::memory_order_relaxed);
+      if(better) {
+        dist[t].store(nd, std::memory_order_relaxed);
+        parent[t] = u;
+      }
+      locked[t].store(false, std::memory_order_release);
+      if(better)
+        buckets[tid][size_t(nd / delta)].push_back(t);
+    };
+
+    std::vector<size_t> offsets(team.size() + 1);
+    bucket frontier;
+    for(size_t current = 0;; ++current) {
+      //advance to the lowest non-empty bucket of any thread
+      size_t next = unsettled;
+      for(const auto& bs : buckets) {
+        auto it = bs.lower_bound(current);
+        if(it != bs.end() and it->first < next)
+          next = it->first;
+      }
+      if(next == unsettled)
+        break;
+      current = next;
+
+      //light-edge phases until the bucket stays empty
+      for(;;) {
+        offsets[0] = 0;
+        for(size_t tid = 0; tid < team.size(); ++tid) {
+          auto it = buckets[tid].find(current);
+          offsets[tid + 1] = offsets[tid] + (it != buckets[tid].end() ? it->second.size() : 0);
+        }
+        if(offsets.back() == 0)
+          break;
+        frontier.resize(offsets.back());
+        team.run([&](size_t tid) {
+            auto it = buckets[tid].find(current);
+            if(it != buckets[tid].end()) {
+              std::copy(it->second.begin(), it->second.end(), frontier.begin() + offsets[tid]);
+              buckets[tid].erase(it);
+            }
+            });
+        team.parallel_for(0, frontier.size(), 64, [&](size_t i, size_t tid) {
+            vertex_descriptor u = frontier[i];
+            distance du = dist[u].load(std::memory_order_relaxed);
+            if(size_t(du / delta) != current)
+              return;
+            if(settled_in[u].exchange(current, std::memory_order_relaxed) != current)
+              settled[tid].push_back(u);
+            auto& v = *table[u];
+            for(adj_edge_iterator aei = v->begin(); aei != v->end(); ++aei)
+              if(!(delta < double((*aei)->property())))
+                relax(u, du, (*aei)->target(), (*aei)->property(), tid);
+            });
+      }
+
+      //heavy edges of everything the bucket held, once
+      team.run([&](size_t tid) {
+          for(vertex_descriptor u : settled[tid]) {
+            distance du = dist[u].load(std::memory_order_relaxed);
+            auto& v = *table[u];
+            for(adj_edge_iterator aei = v->begin(); aei != v->end(); ++aei)
+              if(delta < double((*aei)->property()))
+                relax(u, du, (*aei)->target(), (*aei)->property(), tid);
+          }
+          settled[tid].clear();
+          });
+    }
+
+    for(vertex_descriptor vd : order)
+      if(settled_in[vd].load(std::memory_order_relaxed) != unsettled) {
+        d[vd] = dist[vd].load(std::memory_order_relaxed);
+        p[vd] = parent[vd];
+      }
+  }
+
+
+///@brief Parallel connected components after Afforest (Sutton et al.), edges
+///       taken as undirected. Threads first link every vertex to only its
+///       first neighbor_rounds out-neighbors with lock-free union-find hooks
+///       (larger root under smaller), which already joins most of a large
+///       component. The most frequent label among sampled vertices then
+///       names the largest component, and its vertices skip their remaining
+///       out-edges: every other vertex links all its remaining out-edges and,
+///       so that edges leaving the large component are not lost, all its
+///       in-edges. Without in-edge tracking nothing is skipped. Labels and
+///       count match connected_components.
+///@return Number of components.
+template<typename Graph, typename ComponentMap>
+  size_t parallel_connected_components(const Graph& g, ComponentMap& c,
+      thread_team& team, size_t neighbor_rounds = 2) {
+    typedef typename Graph::vertex_descriptor vertex_descriptor;
+    typedef typename Graph::const_vertex_iterator vertex_iterator;
+    typedef typename Graph::const_adj_edge_iterator adj_edge_iterator;
+    const size_t none = size_t(-1);
+
+    //setup
+    size_t bound = vertex_descriptor_bound(g);
+    std::vector<vertex_iterator> table;
+    table.reserve(g.num_vertices());
+    for(vertex_iterator vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi)
+      table.push_back(vi);
+    std::vector<std::atomic<size_t>> comp(bound);
+    team.parallel_for(0, bound, 4096, [&](size_t i, size_t) {
+        comp[i].store(i, std::memory_order_relaxed);
+        });
+
+    // Hook the larger of the two roots under the smaller.
+    auto link = [&](size_t u, size_t v) {
+      size_t p1 = comp[u].load(std::memory_order_relaxed);
+      size_t p2 = comp[v].load(std::memory_order_relaxed);
+      while(p1 != p2) {
+        size_t high = std::max(p1, p2), low = std::min(p1, p2);
+        size_t p_high = comp[high].load(std::memory_order_relaxed);
+        if(p_high == low)
+          break;
+        if(p_high == high and
+            comp[high].compare_exchange_strong(p_high, low, std::memory_order_relaxed))
+          break;
+        p1 = comp[comp[high].load(std::memory_order_relaxed)].load(std::memory_order_relaxed);
+        p2 = comp[low].load(std::memory_order_relaxed);
+      }
+    };
+
+    // Point every vertex straight at its root.
+    auto compress = [&] {
+      team.parallel_for(0, bound, 4096, [&](size_t i, size_t) {
+          for(;;) {
+            size_t pi = comp[i].load(std::memory_order_relaxed);
+            size_t gi = comp[pi].load(std::memory_order_relaxed);
+            if(pi == gi)
+              break;
+            comp[i].store(gi, std::memory_order_relaxed);
+          }
+          });
+    };
+
+    //sparse sampling: the r-th out-neighbor of every vertex, round by round
+    for(size_t r = 0; r < neighbor_rounds; ++r) {
+      team.parallel_for(0, table.size(), 256, [&](size_t i, size_t) {
+          auto& v = *table[i];
+          adj_edge_iterator aei = v->begin();
+          for(size_t k = 0; k < r and aei != v->end(); ++k)
+            ++aei;
+          if(aei != v->end())
+            link(v->descriptor(), (*aei)->target());
+          });
+      compress();
+    }
+
+    //find the largest intermediate component from a sample of vertices
+    size_t largest = none;
+    if(g.tracks_in_edges() and !table.empty()) {
+      std::mt19937 rng(27491095);
+      std::uniform_int_distribution<size_t> pick(0, table.size() - 1);
+      std::unordered_map<size_t, size_t> counts;
+      size_t best = 0;
+      for(size_t i = 0; i < 1024; ++i) {
+        size_t label = comp[(*table[pick(rng)])->descriptor()].load(std::memory_order_relaxed);
+        if(++counts[label] > best) {
+          best = counts[label];
+          largest = label;
+        }
+      }
+    }
+
+    //finish: remaining edges of every vertex outside the largest component
+    team.parallel_for(0, table.size(), 64, [&](size_t i, size_t) {
+        auto& v = *table[i];
+        vertex_descriptor u = v->descriptor();
+        if(largest != none and comp[u].load(std::memory_order_relaxed) == largest)
+          return;
+        adj_edge_iterator aei = v->begin();
+        for(size_t k = 0; k < neighbor_rounds and aei != v->end(); ++k)
+          ++aei;
+        for(; aei != v->end(); ++aei)
+          link(u, (*aei)->target());
+        if(largest != none)
+          for(aei = v->in_edges_begin(); aei != v->in_edges_end(); ++aei)
+            link(u, (*aei)->source());
+        });
+    compress();
+
+    reset_property_map(c, g);
+    size_t count = 0;
+    for(vertex_iterator vi : table) {
+      vertex_descriptor vd = (*vi)->descriptor();
+      size_t root = comp[vd].load(std::memory_order_relaxed);
+      c[vd] = root;
+      count += root == vd;
+    }
+    return count;
+  }
+
+
+#endif
@@ -0,0 +1,303 @@
+#ifndef _GRAPH_REORDER_H_
+#define _GRAPH_REORDER_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "graph_algorithms.h"
+#include "graph_io.h"
+
+
+// Locality-improving vertex orders. Descriptors follow insertion order, so
+// the neighbors of a vertex are usually far apart in memory and in every
+// descriptor-indexed table. Each *_order function below computes a new order
+// of g's vertices; relabel() then rebuilds g in that order into another graph,
+// whose CSR form (graph_csr.h) or snapshot is the usual thing to search.
+// load_reordered_graph does both on load.
+//
+// The orders look at out-edges only; for a directed graph without its reverse
+// edges they still produce a valid, if less effective, order.
+
+///@brief A vertex order and its inverse. Position i of the order becomes
+///       descriptor base + i of the relabeled graph, base being what its
+///       insert_vertices returned (0 for an empty graph).
+struct vertex_permutation {
+  static const size_t npos = size_t(-1);
+
+  std::vector<size_t> old_of_new; //< Position -> old descriptor
+  std::vector<size_t> new_of_old; //< Old descriptor -> position, npos if absent
+
+  ///@brief Build from old_of_new, filling new_of_old up to bound.
+  vertex_permutation(std::vector<size_t> order, size_t bound) :
+    old_of_new(std::move(order)), new_of_old(bound, size_t(npos)) {
+    for(size_t i = 0; i < old_of_new.size(); ++i)
+      new_of_old[old_of_new[i]] = i;
+  }
+};
+
+
+///@brief Descriptor-indexed copy of g's out-adjacency in flat arrays, which
+///       the order computations scan many times.
+struct reorder_adjacency {
+  std::vector<size_t> vertices;  //< Descriptors in g's iteration order
+  std::vector<size_t> offsets;   //< Descriptor -> start in targets (bound + 1)
+  std::vector<size_t> targets;   //< Out-neighbors grouped by source
+
+  template<typename Graph>
+  explicit reorder_adjacency(const Graph& g) : offsets(vertex_descriptor_bound(g) + 1, 0) {
+    for(auto vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
+      vertices.push_back((*vi)->descriptor());
+      offsets[(*vi)->descriptor() + 1] = std::distance((*vi)->begin(), (*vi)->end());
+    }
+    for(size_t i = 1; i < offsets.size(); ++i)
+      offsets[i] += offsets[i - 1];
+    targets.resize(offsets.back());
+    for(auto vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
+      size_t at = offsets[(*vi)->descriptor()];
+      for(auto aei = (*vi)->begin(); aei != (*vi)->end(); ++aei)
+        targets[at++] = (*aei)->target();
+    }
+  }
+
+  size_t bound() const {return offsets.size() - 1;}
+  size_t degree(size_t v) const {return offsets[v + 1] - offsets[v];}
+  const size_t* begin(size_t v) const {return targets.data() + offsets[v];}
+  const size_t* end(size_t v) const {return targets.data() + offsets[v + 1];}
+};
+
+
+///@brief Vertices by descending out-degree, ties in descriptor order. Hubs
+///       end up together at the front of every descriptor-indexed table.
+template<typename Graph>
+  vertex_permutation degree_order(const Graph& g) {
+    reorder_adjacency adj(g);
+    std::vector<size_t> order = adj.vertices;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return adj.degree(a) != adj.degree(b) ? adj.degree(a) > adj.degree(b) : a < b;
+    });
+    return vertex_permutation(std::move(order), adj.bound());
+  }
+
+
+///@brief Reverse Cuthill-McKee: a breadth-first order from a low-degree
+///       vertex of each component, neighbors taken by ascending degree, then
+///       reversed. It keeps adjacent vertices close, narrowing the bandwidth
+///       of the adjacency matrix.
+template<typename Graph>
+  vertex_permutation reverse_cuthill_mckee_order(const Graph& g) {
+    reorder_adjacency adj(g);
+    std::vector<size_t> starts = adj.vertices;
+    std::stable_sort(starts.begin(), starts.end(), [&](size_t a, size_t b) {
+      return adj.degree(a) < adj.degree(b);
+    });
+
+    descriptor_bitmap visited(adj.bound());
+    std::vector<size_t> order, neighbors;
+    order.reserve(starts.size());
+    for(size_t root : starts) {
+      if(visited.test(root))
+        continue;
+      visited.set(root);
+      size_t head = order.size();
+      order.push_back(root);
+      while(head < order.size()) {
+        size_t v = order[head++];
+        neighbors.clear();
+        for(const size_t* t = adj.begin(v); t != adj.end(v); ++t)
+          if(!visited.test(*t)) {
+            visited.set(*t);
+            neighbors.push_back(*t);
+          }
+        std::stable_sort(neighbors.begin(), neighbors.end(), [&](size_t a, size_t b) {
+          return adj.degree(a) < adj.degree(b);
+        });
+        order.insert(order.end(), neighbors.begin(), neighbors.end());
+      }
+    }
+    std::reverse(order.begin(), order.end());
+    return vertex_permutation(std::move(order), adj.bound());
+  }
+
+
+///@brief Max-priority structure over integer scores that change by one at
+///       a time: a doubly linked list of vertices per score and a pointer to
+///       the highest non-empty list, so raising, lowering and removing are
+///       O(1) and taking the top costs amortized O(1) as well.
+class unit_heap {
+  public:
+    static const size_t none = size_t(-1);
+
+    ///@brief Put every vertex of order in at score 0; the last is on top.
+    unit_heap(const std::vector<size_t>& order, size_t bound) :
+      m_score(bound, 0), m_prev(bound, size_t(none)), m_next(bound, size_t(none)),
+      m_heads(1, size_t(none)), m_top(0), m_size(order.size()) {
+      for(size_t v : order)
+        link(v);
+    }
+
+    bool empty() const {return m_size == 0;}
+    size_t top() {
+      while(m_top > 0 and m_heads[m_top] == none)
+        --m_top;
+      return m_heads[m_top];
+    }
+
+    void raise(size_t v) {
+      unlink(v);
+      if(++m_score[v] == m_heads.size())
+        m_heads.push_back(size_t(none));
+      m_top = std::max(m_top, m_score[v]);
+      link(v);
+    }
+
+    void lower(size_t v) {
+      unlink(v);
+      --m_score[v];
+      link(v);
+    }
+
+    void remove(size_t v) {
+      unlink(v);
+      --m_size;
+    }
+
+  private:
+    void link(size_t v) {
+      size_t& head = m_heads[m_score[v]];
+      m_prev[v] = none;
+      m_next[v] = head;
+      if(head != none)
+        m_prev[head] = v;
+      head = v;
+    }
+
+    void unlink(size_t v) {
+      if(m_prev[v] != none)
+        m_next[m_prev[v]] = m_next[v];
+      else
+        m_heads[m_score[v]] = m_next[v];
+      if(m_next[v] != none)
+        m_prev[m_next[v]] = m_prev[v];
+    }
+
+    std::vector<size_t> m_score;  //< Vertex -> score
+    std::vector<size_t> m_prev;   //< Vertex -> previous in its score's list
+    std::vector<size_t> m_next;   //< Vertex -> next in its score's list
+    std::vector<size_t> m_heads;  //< Score -> first vertex of its list
+    size_t m_top;                 //< No list above this score is non-empty
+    size_t m_size;                //< Vertices still in the heap
+};
+
+
+///@brief Gorder (Wei et al.): greedily append the vertex that shares the
+///       most with the last window vertices placed, counting one for each
+///       edge to one of them and one for each common neighbor, so vertices
+///       used together by a traversal land in the same cache lines. Scores
+///       live in a unit_heap; among equal scores the most recently touched
+///       vertex wins, and with no score left the highest-degree unplaced
+///       vertex starts over. Common neighbors are not counted through
+///       vertices of degree above sqrt(n), whose neighbor lists would make
+///       each step cost O(n) while adding little locality.
+template<typename Graph>
+  vertex_permutation gorder_order(const Graph& g, size_t window = 5) {
+    reorder_adjacency adj(g);
+    const size_t hub_degree = std::max<size_t>(1, std::sqrt(double(adj.vertices.size())));
+    std::vector<size_t> by_degree = adj.vertices;
+    std::stable_sort(by_degree.begin(), by_degree.end(), [&](size_t a, size_t b) {
+      return adj.degree(a) < adj.degree(b);
+    });
+    unit_heap heap(by_degree, adj.bound());
+    descriptor_bitmap placed(adj.bound());
+
+    // raise (or lower) the score of every unplaced vertex u shares with
+    auto update = [&](size_t u, bool raise) {
+      auto bump = [&](size_t x) {
+        if(placed.test(x))
+          return;
+        if(raise)
+          heap.raise(x);
+        else
+          heap.lower(x);
+      };
+      for(const size_t* t = adj.begin(u); t != adj.end(u); ++t) {
+        bump(*t);
+        if(adj.degree(*t) <= hub_degree)
+          for(const size_t* s = adj.begin(*t); s != adj.end(*t); ++s)
+            if(*s != u)
+              bump(*s);
+      }
+    };
+
+    std::vector<size_t> order;
+    order.reserve(adj.vertices.size());
+    while(!heap.empty()) {
+      size_t v = heap.top();
+      heap.remove(v);
+      placed.set(v);
+      order.push_back(v);
+      update(v, true);
+      if(order.size() > window)
+        update(order[order.size() - 1 - window], false);
+    }
+    return vertex_permutation(std::move(order), adj.bound());
+  }
+
+
+///@brief Insert g's vertices into out in the order of perm, then its edges,
+///       translated, in one batch. out should be empty, so that position i
+///       becomes descriptor i; the descriptor of position 0 is returned.
+template<typename Graph, typename OutGraph>
+  size_t relabel(const Graph& g, const vertex_permutation& perm, OutGraph& out) {
+    typedef typename std::decay<decltype(
+        (*std::declval<const Graph&>().vertices_cbegin())->property())>::type vertex_property;
+    std::vector<vertex_property> properties(perm.old_of_new.size());
+    for(auto vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi)
+      properties[perm.new_of_old[(*vi)->descriptor()]] = (*vi)->property();
+    size_t base = out.insert_vertices(properties.begin(), properties.end());
+
+    std::vector<typename OutGraph::edge_triple> edges;
+    edges.reserve(g.num_edges());
+    for(auto vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
+      size_t s = base + perm.new_of_old[(*vi)->descriptor()];
+      for(auto aei = (*vi)->begin(); aei != (*vi)->end(); ++aei)
+        edges.emplace_back(s, base + perm.new_of_old[(*aei)->target()], (*aei)->property());
+    }
+    // sources in new order, so the batch links each adjacency list in one run
+    std::sort(edges.begin(), edges.end(), [](const typename OutGraph::edge_triple& a,
+          const typename OutGraph::edge_triple& b) {
+      return std::get<0>(a) != std::get<0>(b) ? std::get<0>(a) < std::get<0>(b)
+        : std::get<1>(a) < std::get<1>(b);
+    });
+    out.insert_edges(edges.begin(), edges.end());
+    return base;
+  }
+
+
+///@brief load_graph (graph_io.h) into a scratch graph, then relabel it into
+///       g in the order computed by order, a callable such as
+///       [](const Graph& h) {return gorder_order(h);}. g should be empty, so
+///       that file vertex i becomes descriptor perm->new_of_old[i]; perm, if
+///       given, receives the permutation. Returns false, leaving g unchanged,
+///       if the file cannot be loaded.
+template<typename Graph, typename Order>
+  bool load_reordered_graph(const std::string& path, Graph& g, Order order,
+      vertex_permutation* perm = nullptr) {
+    Graph loaded(g.tracks_in_edges());
+    if(!load_graph(path, loaded))
+      return false;
+    vertex_permutation p = order(static_cast<const Graph&>(loaded));
+    relabel(loaded, p, g);
+    if(perm)
+      *perm = std::move(p);
+    return true;
+  }
+
+
+#endif
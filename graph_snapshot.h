@@ -0,0 +1,230 @@
+#ifndef _GRAPH_SNAPSHOT_H_
+#define _GRAPH_SNAPSHOT_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "graph_csr.h"
+#include "graph_io.h"
+
+
+// Versioned, checksummed binary snapshots. A snapshot is the CSR form of a
+// graph (graph_csr.h) written as six arrays behind a fixed header:
+//
+//   header | slots | descriptors | offsets | targets | vertex props | edge props
+//
+// Each array starts on a 64-byte boundary. Integers are 64-bit in native byte
+// order and properties are stored as raw bytes, so they must be trivially
+// copyable. open_snapshot maps the file and serves the returned graph_csr
+// straight from the mapping; nothing is copied or re-inserted.
+
+/// Magic bytes at the start of every snapshot.
+static const char snapshot_magic[8] = {'G', 'R', 'A', 'P', 'H', 'S', 'N', 'P'};
+
+/// Bumped whenever the layout changes; older versions are rejected.
+static const uint32_t snapshot_version = 1;
+
+///@brief Fixed-size header of a snapshot file.
+struct snapshot_header {
+  char magic[8];                  //< snapshot_magic
+  uint32_t version;               //< snapshot_version
+  uint32_t header_size;           //< sizeof(snapshot_header)
+  uint32_t vertex_property_size;  //< sizeof(VertexProperty)
+  uint32_t edge_property_size;    //< sizeof(EdgeProperty)
+  uint64_t num_vertices;          //< Vertices, i.e. slots
+  uint64_t num_edges;             //< Edges
+  uint64_t num_descriptors;       //< Size of the descriptor -> slot table
+  uint64_t payload_size;          //< Bytes after the header
+  uint64_t checksum;              //< snapshot_checksum of the payload
+  uint64_t reserved[8];           //< Zero; pads the header to 128 bytes
+};
+
+static_assert(sizeof(snapshot_header) % 64 == 0, "snapshot arrays must stay 64-byte aligned");
+static_assert(sizeof(size_t) == sizeof(uint64_t), "snapshots store descriptors as 64-bit values");
+
+///@brief 64-bit checksum over a byte range. Four independent multiply-xor
+///       lanes over 8-byte words keep it close to memory bandwidth.
+inline uint64_t snapshot_checksum(const char* data, size_t size) {
+  const uint64_t prime = 0x9E3779B97F4A7C15ull;
+  uint64_t lane[4] = {0x243F6A8885A308D3ull, 0x13198A2E03707344ull,
+    0xA4093822299F31D0ull, 0x082EFA98EC4E6C89ull};
+  size_t i = 0;
+  for(; i + 32 <= size; i += 32)
+    for(size_t l = 0; l < 4; ++l) {
+      uint64_t w;
+      std::memcpy(&w, data + i + 8 * l, 8);
+      lane[l] = (lane[l] ^ w) * prime;
+      lane[l] ^= lane[l] >> 29;
+    }
+  uint64_t h = size;
+  for(size_t l = 0; l < 4; ++l)
+    h = (h ^ lane[l]) * prime;
+  for(; i < size; ++i)
+    h = (h ^ uint8_t(data[i])) * prime;
+  return h ^ (h >> 32);
+}
+
+///@brief Byte offsets of the arrays of a snapshot, relative to the payload.
+///       valid is false when the counts are so large that an offset would
+///       not fit in 64 bits; the other members are then meaningless.
+struct snapshot_layout {
+  uint64_t slots, descriptors, offsets, targets, vertex_properties, edge_properties, end;
+  bool valid;
+
+  snapshot_layout(uint64_t num_vertices, uint64_t num_edges, uint64_t num_descriptors,
+      uint64_t vertex_property_size, uint64_t edge_property_size) : valid(true) {
+    const uint64_t max = uint64_t(-1) - 127;
+    // aligned end of count elements of size bytes starting at at
+    auto after = [&](uint64_t at, uint64_t count, uint64_t size) {
+      if(at > max or (size != 0 and count > (max - at) / size)) {
+        valid = false;
+        return uint64_t(-1);
+      }
+      return (at + count * size + 63) & ~uint64_t(63);
+    };
+    slots = 0;
+    descriptors = after(slots, num_descriptors, 8);
+    offsets = after(descriptors, num_vertices, 8);
+    targets = after(offsets + 8, num_vertices, 8);
+    vertex_properties = after(targets, num_edges, 8);
+    edge_properties = after(vertex_properties, num_vertices, vertex_property_size);
+    end = after(edge_properties, num_edges, edge_property_size);
+  }
+};
+
+///@brief Cheap structural check of the arrays of a snapshot: offsets start at
+///       zero, never decrease and end at the edge count, and every slot,
+///       descriptor and target is in range and consistent. Linear in the
+///       arrays but far cheaper than the checksum; it keeps a corrupt file
+///       opened without verification from reading out of bounds.
+template<typename V, typename E>
+  bool snapshot_well_formed(const typename graph_csr<V, E>::arrays& a) {
+    const size_t npos = graph_csr<V, E>::npos;
+    size_t n = a.descriptors.size(), m = a.targets.size(), bound = a.slots.size();
+    if(a.offsets[0] != 0 or a.offsets[n] != m)
+      return false;
+    for(size_t s = 0; s < n; ++s)
+      if(a.offsets[s] > a.offsets[s + 1] or a.descriptors[s] >= bound or
+          a.slots[a.descriptors[s]] != s)
+        return false;
+    for(size_t d = 0; d < bound; ++d)
+      if(a.slots[d] != npos and (a.slots[d] >= n or a.descriptors[a.slots[d]] != d))
+        return false;
+    for(size_t i = 0; i < m; ++i)
+      if(a.targets[i] >= bound or a.slots[a.targets[i]] == npos)
+        return false;
+    return true;
+  }
+
+
+///@brief Write a CSR snapshot to path. Returns false on I/O failure.
+template<typename V, typename E>
+  bool save_snapshot(const graph_csr<V, E>& g, const std::string& path) {
+    static_assert(std::is_trivially_copyable<V>::value and std::is_trivially_copyable<E>::value,
+        "snapshot properties must be trivially copyable");
+    typename graph_csr<V, E>::arrays a = g.data();
+    snapshot_layout layout(a.descriptors.size(), a.targets.size(), a.slots.size(),
+        sizeof(V), sizeof(E));
+
+    std::vector<char> payload(layout.end, 0);
+    auto put = [&](uint64_t at, const void* data, size_t bytes) {
+      if(bytes)
+        std::memcpy(payload.data() + at, data, bytes);
+    };
+    put(layout.slots, a.slots.data(), 8 * a.slots.size());
+    put(layout.descriptors, a.descriptors.data(), 8 * a.descriptors.size());
+    put(layout.offsets, a.offsets.data(), 8 * a.offsets.size());
+    put(layout.targets, a.targets.data(), 8 * a.targets.size());
+    put(layout.vertex_properties, a.vertex_properties.data(), sizeof(V) * a.vertex_properties.size());
+    put(layout.edge_properties, a.edge_properties.data(), sizeof(E) * a.edge_properties.size());
+
+    snapshot_header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, snapshot_magic, sizeof(h.magic));
+    h.version = snapshot_version;
+    h.header_size = sizeof(snapshot_header);
+    h.vertex_property_size = sizeof(V);
+    h.edge_property_size = sizeof(E);
+    h.num_vertices = a.descriptors.size();
+    h.num_edges = a.targets.size();
+    h.num_descriptors = a.slots.size();
+    h.payload_size = payload.size();
+    h.checksum = snapshot_checksum(payload.data(), payload.size());
+
+    // write to a temporary and rename, so readers never see half a file
+    std::string tmp = path + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if(!f)
+      return false;
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 and
+      (payload.empty() or std::fwrite(payload.data(), payload.size(), 1, f) == 1);
+    ok = std::fclose(f) == 0 and ok;
+    if(ok)
+      ok = std::rename(tmp.c_str(), path.c_str()) == 0;
+    if(!ok)
+      std::remove(tmp.c_str());
+    return ok;
+  }
+
+///@brief Write a snapshot of a graph or graph_vector to path by way of its
+///       CSR form. Returns false on I/O failure.
+template<typename Graph>
+  bool save_snapshot(const Graph& g, const std::string& path) {
+    typedef typename std::decay<decltype(
+        (*std::declval<const Graph&>().vertices_cbegin())->property())>::type V;
+    typedef typename std::decay<decltype(
+        (*std::declval<const Graph&>().edges_cbegin())->property())>::type E;
+    return save_snapshot(graph_csr<V, E>(g), path);
+  }
+
+///@brief Map a snapshot written by save_snapshot and return a read-only graph
+///       whose arrays live in the mapping. Returns null if the file cannot
+///       be read, has another version or property layout, is truncated, or
+///       fails its checksum (with verify_checksum) or the structural check
+///       of snapshot_well_formed (without). advice is the madvise hint for
+///       the mapping; searches touch it in no particular order, so the
+///       default leaves read-ahead to the kernel.
+template<typename V, typename E>
+  std::unique_ptr<graph_csr<V, E>> open_snapshot(const std::string& path,
+      bool verify_checksum = true, int advice = MADV_NORMAL) {
+    static_assert(std::is_trivially_copyable<V>::value and std::is_trivially_copyable<E>::value,
+        "snapshot properties must be trivially copyable");
+    typedef typename graph_csr<V, E>::vertex_descriptor vertex_descriptor;
+    std::shared_ptr<mapped_file> file = std::make_shared<mapped_file>(path, advice);
+    if(!file->is_open() or file->size() < sizeof(snapshot_header))
+      return nullptr;
+
+    snapshot_header h;
+    std::memcpy(&h, file->data(), sizeof(h));
+    if(std::memcmp(h.magic, snapshot_magic, sizeof(h.magic)) != 0 or
+        h.version != snapshot_version or h.header_size != sizeof(snapshot_header) or
+        h.vertex_property_size != sizeof(V) or h.edge_property_size != sizeof(E))
+      return nullptr;
+    snapshot_layout layout(h.num_vertices, h.num_edges, h.num_descriptors, sizeof(V), sizeof(E));
+    if(!layout.valid or h.payload_size != layout.end or file->size() - sizeof(h) != h.payload_size)
+      return nullptr;
+    const char* payload = file->data() + sizeof(h);
+    if(verify_checksum and snapshot_checksum(payload, h.payload_size) != h.checksum)
+      return nullptr;
+
+    typename graph_csr<V, E>::arrays a;
+    a.slots = {reinterpret_cast<const size_t*>(payload + layout.slots), h.num_descriptors};
+    a.descriptors = {reinterpret_cast<const vertex_descriptor*>(payload + layout.descriptors),
+      h.num_vertices};
+    a.offsets = {reinterpret_cast<const size_t*>(payload + layout.offsets), h.num_vertices + 1};
+    a.targets = {reinterpret_cast<const vertex_descriptor*>(payload + layout.targets), h.num_edges};
+    a.vertex_properties = {reinterpret_cast<const V*>(payload + layout.vertex_properties),
+      h.num_vertices};
+    a.edge_properties = {reinterpret_cast<const E*>(payload + layout.edge_properties), h.num_edges};
+    if(!verify_checksum and !snapshot_well_formed<V, E>(a))
+      return nullptr;
+    return std::unique_ptr<graph_csr<V, E>>(new graph_csr<V, E>(a, file));
+  }
+
+
+#endif
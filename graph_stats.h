@@ -0,0 +1,169 @@
+#ifndef _GRAPH_STATS_H_
+#define _GRAPH_STATS_H_
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(GRAPH_STATS) && defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+// Opt-in instrumentation of the graph containers and algorithms. Building
+// with -DGRAPH_STATS (make STATS=1) turns every GRAPH_STAT_ADD into a relaxed
+// atomic add on a process-wide counter; without it the macro expands to
+// nothing and read_graph_stats() returns zeros. A caller attributes work to
+// an operation by reading the counters before and after it and subtracting.
+//
+// On Linux, perf_counters additionally reads cycles, cache misses and branch
+// misses around a region through perf_event_open. It is likewise compiled
+// out without GRAPH_STATS, and reports itself unavailable when the kernel
+// refuses the events (see /proc/sys/kernel/perf_event_paranoid).
+
+///@brief Snapshot of the counters, or the difference of two snapshots.
+struct graph_stats {
+  uint64_t hash_lookups;      //< flat_hash_set lookups
+  uint64_t hash_probes;       //< Groups (inline: slot arrays) those lookups scanned
+  uint64_t rehashes;          //< flat_hash_set tables rebuilt
+  uint64_t scan_lookups;      //< graph_vector find_edge calls
+  uint64_t scan_steps;        //< Adjacency entries those calls compared
+  uint64_t allocations;       //< Heap blocks taken by nodes, pools and containers
+  uint64_t vertices_visited;  //< Vertices expanded by traversals
+  uint64_t edges_examined;    //< Edges scanned by traversals
+
+  graph_stats operator-(const graph_stats& o) const {
+    return {hash_lookups - o.hash_lookups, hash_probes - o.hash_probes,
+      rehashes - o.rehashes, scan_lookups - o.scan_lookups, scan_steps - o.scan_steps,
+      allocations - o.allocations, vertices_visited - o.vertices_visited,
+      edges_examined - o.edges_examined};
+  }
+};
+
+///@brief The process-wide counters behind GRAPH_STAT_ADD.
+struct graph_stat_counters {
+  std::atomic<uint64_t> hash_lookups{0};
+  std::atomic<uint64_t> hash_probes{0};
+  std::atomic<uint64_t> rehashes{0};
+  std::atomic<uint64_t> scan_lookups{0};
+  std::atomic<uint64_t> scan_steps{0};
+  std::atomic<uint64_t> allocations{0};
+  std::atomic<uint64_t> vertices_visited{0};
+  std::atomic<uint64_t> edges_examined{0};
+
+  static graph_stat_counters& global() {
+    static graph_stat_counters c;
+    return c;
+  }
+};
+
+#ifdef GRAPH_STATS
+static const bool graph_stats_enabled = true;
+#define GRAPH_STAT_ADD(counter, n) \
+  graph_stat_counters::global().counter.fetch_add((n), std::memory_order_relaxed)
+#else
+static const bool graph_stats_enabled = false;
+#define GRAPH_STAT_ADD(counter, n) ((void)0)
+#endif
+
+///@brief Current counter values; zeros unless built with GRAPH_STATS.
+inline graph_stats read_graph_stats() {
+  graph_stat_counters& c = graph_stat_counters::global();
+  auto get = [](const std::atomic<uint64_t>& x) {return x.load(std::memory_order_relaxed);};
+  return {get(c.hash_lookups), get(c.hash_probes), get(c.rehashes), get(c.scan_lookups),
+    get(c.scan_steps), get(c.allocations), get(c.vertices_visited), get(c.edges_examined)};
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// Hardware counters of the calling thread between start() and stop():
+/// cycles, last-level cache misses and branch mispredictions, opened as one
+/// perf_event_open group so the three cover the same instructions.
+////////////////////////////////////////////////////////////////////////////////
+class perf_counters {
+  public:
+    perf_counters() : m_cycles(0), m_cache_misses(0), m_branch_misses(0) {
+#if defined(GRAPH_STATS) && defined(__linux__)
+      const uint64_t configs[num_events] = {PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+      for(size_t i = 0; i < num_events; ++i) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = configs[i];
+        attr.disabled = i == 0;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+        m_fd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, i == 0 ? -1 : m_fd[0], 0);
+      }
+#endif
+    }
+
+    ~perf_counters() {
+#if defined(GRAPH_STATS) && defined(__linux__)
+      for(size_t i = 0; i < num_events; ++i)
+        if(m_fd[i] >= 0)
+          close(m_fd[i]);
+#endif
+    }
+
+    perf_counters(const perf_counters&) = delete;
+    perf_counters& operator=(const perf_counters&) = delete;
+
+    ///@brief Whether the kernel granted every event.
+    bool available() const {
+#if defined(GRAPH_STATS) && defined(__linux__)
+      for(size_t i = 0; i < num_events; ++i)
+        if(m_fd[i] < 0)
+          return false;
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    void start() {
+#if defined(GRAPH_STATS) && defined(__linux__)
+      if(available()) {
+        ioctl(m_fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(m_fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+      }
+#endif
+    }
+
+    void stop() {
+#if defined(GRAPH_STATS) && defined(__linux__)
+      if(!available())
+        return;
+      ioctl(m_fd[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+      uint64_t values[1 + num_events]; // count, then one value per event
+      if(read(m_fd[0], values, sizeof(values)) == ssize_t(sizeof(values))) {
+        m_cycles = values[1];
+        m_cache_misses = values[2];
+        m_branch_misses = values[3];
+      }
+#endif
+    }
+
+    ///@brief Counts of the last start()/stop() region.
+    uint64_t cycles() const {return m_cycles;}
+    uint64_t cache_misses() const {return m_cache_misses;}
+    uint64_t branch_misses() const {return m_branch_misses;}
+
+  private:
+    static const size_t num_events = 3;
+#if defined(GRAPH_STATS) && defined(__linux__)
+    int m_fd[num_events];       //< Group leader (cycles) first; -1 if refused
+#endif
+    uint64_t m_cycles;          //< Cycles
+    uint64_t m_cache_misses;    //< Last-level cache misses
+    uint64_t m_branch_misses;   //< Mispredicted branches
+};
+
+
+#endif
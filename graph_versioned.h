@@ -0,0 +1,536 @@
+#ifndef _GRAPH_VERSIONED_H_
+#define _GRAPH_VERSIONED_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+
+// Multi-version graph for readers that must keep querying while a batch is
+// ingested. versioned_graph has one writer, which changes a private draft;
+// commit() publishes the draft as the next version in one atomic pointer
+// store. A reader calls pin() to get a graph_version, an immutable snapshot
+// that stays valid and unchanged for as long as it is held, whatever the
+// writer does meanwhile, and runs the searches of graph_algorithms.h on it
+// without further synchronization.
+//
+// Versions share structure. Each vertex's property and adjacency live in
+// their own immutable record, and records are grouped 64 to a chunk; a
+// version is a table of chunk pointers. The writer copies a record the first
+// time a draft changes it and a chunk the first time a draft changes one of
+// its records, so a commit costs the chunk table plus the records it touched,
+// and every other record and chunk is shared with the versions before it.
+// Records, chunks and versions are reference counted, so an old version is
+// freed when its last reader lets go.
+
+template<typename VertexProperty, typename EdgeProperty>
+class versioned_graph;
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// The shared, immutable parts of a version.
+////////////////////////////////////////////////////////////////////////////////
+template<typename VertexProperty, typename EdgeProperty>
+struct graph_version_data {
+  static const size_t chunk_size = 64;
+
+  ///@brief One vertex: its property, out-edges and in-neighbors.
+  struct record {
+    size_t descriptor;                                  //< Vertex descriptor
+    VertexProperty property;                            //< Vertex property
+    std::vector<std::pair<size_t, EdgeProperty>> out;   //< (target, property) per out-edge
+    std::vector<size_t> in;                             //< Source of each in-edge
+    uint64_t created;                                   //< Version that made this copy
+  };
+
+  struct chunk {
+    std::shared_ptr<const record> slots[chunk_size];    //< Null for absent descriptors
+    uint64_t created;                                   //< Version that made this copy
+  };
+
+  std::vector<std::shared_ptr<const chunk>> chunks;    //< Descriptor / chunk_size -> chunk
+  size_t bound = 0;                                     //< One past the largest descriptor handed out
+  size_t num_vertices = 0;
+  size_t num_edges = 0;
+  uint64_t number = 0;                                  //< Version number, 0 for the empty graph
+
+  const record* find(size_t vd) const {
+    return vd < bound ? chunks[vd / chunk_size]->slots[vd % chunk_size].get() : nullptr;
+  }
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// A pinned, immutable version of a versioned_graph. It exposes the same
+/// descriptor and iterator typedefs as graph_csr, with the same light
+/// handles, so the searches in graph_algorithms.h run on it unchanged.
+/// Vertices are visited in descriptor order and each vertex's out-edges in
+/// insertion order. Copies are cheap and share the version.
+////////////////////////////////////////////////////////////////////////////////
+template<typename VertexProperty, typename EdgeProperty>
+class graph_version {
+
+  typedef graph_version_data<VertexProperty, EdgeProperty> data;
+  typedef typename data::record record;
+  class vertex;
+  class edge;
+
+  public:
+
+    // Required public types
+
+    /// Unique vertex identifier
+    typedef size_t vertex_descriptor;
+
+    /// Unique edge identifier represents pair of vertex descriptors
+    typedef std::pair<size_t, size_t> edge_descriptor;
+
+    class const_vertex_iterator;
+    class const_edge_iterator;
+    class const_adj_edge_iterator;
+
+    // A version is read-only, so the mutable iterators are the const ones.
+    typedef const_vertex_iterator vertex_iterator;
+    typedef const_edge_iterator edge_iterator;
+    typedef const_adj_edge_iterator adj_edge_iterator;
+
+    ///@brief The empty version 0.
+    graph_version() : m_data(std::make_shared<const data>()) { }
+
+    ///@brief vertex iterator operations
+    const_vertex_iterator vertices_begin() const {return vertices_cbegin();}
+    const_vertex_iterator vertices_cbegin() const {return const_vertex_iterator(m_data.get(), 0);}
+    const_vertex_iterator vertices_end() const {return vertices_cend();}
+    const_vertex_iterator vertices_cend() const {
+      return const_vertex_iterator(m_data.get(), m_data->bound);
+    }
+
+    ///@brief edge iterator operations
+    const_edge_iterator edges_begin() const {return edges_cbegin();}
+    const_edge_iterator edges_cbegin() const {return const_edge_iterator(m_data.get(), 0, 0);}
+    const_edge_iterator edges_end() const {return edges_cend();}
+    const_edge_iterator edges_cend() const {
+      return const_edge_iterator(m_data.get(), m_data->bound, 0);
+    }
+
+    ///@brief Define accessors
+    size_t num_vertices() const {return m_data->num_vertices;}
+    size_t num_edges() const {return m_data->num_edges;}
+    uint64_t number() const {return m_data->number;}
+
+    const_vertex_iterator find_vertex(vertex_descriptor vd) const {
+      return m_data->find(vd) ? const_vertex_iterator(m_data.get(), vd) : vertices_cend();
+    }
+
+    const_edge_iterator find_edge(edge_descriptor ed) const {
+      const record* r = m_data->find(ed.first);
+      if(!r)
+        return edges_cend();
+      for(size_t i = 0; i < r->out.size(); ++i)
+        if(r->out[i].first == ed.second)
+          return const_edge_iterator(m_data.get(), ed.first, i);
+      return edges_cend();
+    }
+
+    // Friend declaration for output.
+    template<typename V, typename E>
+    friend std::ostream& operator<<(std::ostream&, const graph_version<V, E>&);
+
+  private:
+    explicit graph_version(std::shared_ptr<const data> d) : m_data(std::move(d)) { }
+
+    std::shared_ptr<const data> m_data; //< Keeps the version and all it shares alive
+
+    friend class versioned_graph<VertexProperty, EdgeProperty>;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Handle to a vertex record.
+    ////////////////////////////////////////////////////////////////////////////
+    class vertex {
+      public:
+        explicit vertex(const record* r) : m_record(r) { }
+
+        const vertex* operator->() const {return this;}
+
+        //iterators
+        const_adj_edge_iterator begin() const {return const_adj_edge_iterator(m_record, 0);}
+        const_adj_edge_iterator cbegin() const {return begin();}
+        const_adj_edge_iterator end() const {
+          return const_adj_edge_iterator(m_record, m_record->out.size());
+        }
+        const_adj_edge_iterator cend() const {return end();}
+
+        //accessors
+        vertex_descriptor descriptor() const {return m_record->descriptor;}
+        const VertexProperty& property() const {return m_record->property;}
+
+      private:
+        const record* m_record;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Handle to an out-edge of a vertex record.
+    ////////////////////////////////////////////////////////////////////////////
+    class edge {
+      public:
+        edge(const record* r, size_t i) : m_record(r), m_index(i) { }
+
+        const edge* operator->() const {return this;}
+
+        //accessors
+        vertex_descriptor source() const {return m_record->descriptor;}
+        vertex_descriptor target() const {return m_record->out[m_index].first;}
+        edge_descriptor descriptor() const {return {source(), target()};}
+        const EdgeProperty& property() const {return m_record->out[m_index].second;}
+
+      private:
+        const record* m_record;
+        size_t m_index;
+    };
+
+  public:
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Iterates present descriptors in order.
+    ////////////////////////////////////////////////////////////////////////////
+    class const_vertex_iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef vertex value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const vertex* pointer;
+        typedef const vertex reference;
+
+        const_vertex_iterator() : m_data(nullptr), m_vd(0) { }
+        const_vertex_iterator(const data* d, size_t vd) : m_data(d), m_vd(vd) {
+          skip_absent();
+        }
+
+        const vertex operator*() const {return vertex(m_data->find(m_vd));}
+        const_vertex_iterator& operator++() {
+          ++m_vd;
+          skip_absent();
+          return *this;
+        }
+        const_vertex_iterator operator++(int) {auto t = *this; ++*this; return t;}
+        bool operator==(const const_vertex_iterator& o) const {return m_vd == o.m_vd;}
+        bool operator!=(const const_vertex_iterator& o) const {return m_vd != o.m_vd;}
+
+      private:
+        void skip_absent() {
+          while(m_data and m_vd < m_data->bound and !m_data->find(m_vd))
+            ++m_vd;
+        }
+
+        const data* m_data;
+        size_t m_vd;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Iterates the out-edges of a single vertex.
+    ////////////////////////////////////////////////////////////////////////////
+    class const_adj_edge_iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef edge value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const edge* pointer;
+        typedef const edge reference;
+
+        const_adj_edge_iterator() : m_record(nullptr), m_index(0) { }
+        const_adj_edge_iterator(const record* r, size_t i) : m_record(r), m_index(i) { }
+
+        const edge operator*() const {return edge(m_record, m_index);}
+        const_adj_edge_iterator& operator++() {++m_index; return *this;}
+        const_adj_edge_iterator operator++(int) {auto t = *this; ++m_index; return t;}
+        bool operator==(const const_adj_edge_iterator& o) const {return m_index == o.m_index;}
+        bool operator!=(const const_adj_edge_iterator& o) const {return m_index != o.m_index;}
+
+      private:
+        const record* m_record;
+        size_t m_index;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// Iterates every edge, vertex by vertex.
+    ////////////////////////////////////////////////////////////////////////////
+    class const_edge_iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef edge value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const edge* pointer;
+        typedef const edge reference;
+
+        const_edge_iterator() : m_data(nullptr), m_vd(0), m_index(0) { }
+        const_edge_iterator(const data* d, size_t vd, size_t i) :
+          m_data(d), m_vd(vd), m_index(i) {
+          skip_empty_rows();
+        }
+
+        const edge operator*() const {return edge(m_data->find(m_vd), m_index);}
+        const_edge_iterator& operator++() {
+          ++m_index;
+          skip_empty_rows();
+          return *this;
+        }
+        const_edge_iterator operator++(int) {auto t = *this; ++*this; return t;}
+        bool operator==(const const_edge_iterator& o) const {
+          return m_vd == o.m_vd and m_index == o.m_index;
+        }
+        bool operator!=(const const_edge_iterator& o) const {return !(*this == o);}
+
+      private:
+        void skip_empty_rows() {
+          if(!m_data)
+            return;
+          while(m_vd < m_data->bound) {
+            const record* r = m_data->find(m_vd);
+            if(r and m_index < r->out.size())
+              return;
+            ++m_vd;
+            m_index = 0;
+          }
+        }
+
+        const data* m_data;
+        size_t m_vd;
+        size_t m_index;
+    };
+};
+
+///@brief Define output for a version, in the same format as graph.
+template<typename V, typename E>
+std::ostream& operator<<(std::ostream& os, const graph_version<V, E>& g) {
+  os << g.num_vertices() << " " << g.num_edges() << std::endl;
+  for(auto i = g.vertices_cbegin(); i != g.vertices_cend(); ++i)
+    os << (*i)->property() << std::endl;
+  for(auto i = g.edges_cbegin(); i != g.edges_cend(); ++i)
+    os << (*i)->source() << " " << (*i)->target() << " "
+      << (*i)->property() << std::endl;
+  return os;
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// The writer side: one thread changes the draft with the usual modifiers,
+/// which behave as graph's do (an edge is added once, edges with a missing
+/// endpoint are skipped, erase_vertex also erases the vertex's edges), and
+/// publishes it with commit(). Any number of threads may call pin() and
+/// committed() concurrently with the writer; the modifiers, commit() and
+/// discard() must not run concurrently with each other.
+///
+/// The first change after each commit starts the draft by copying the whole
+/// chunk table, O(V/64) reference count bumps; later changes to the same
+/// draft cost only the records and chunks they touch. insert_edge finds
+/// duplicates through a hash of each changed source's out-neighbors, built
+/// once per draft, so a batch into a hub vertex stays linear.
+////////////////////////////////////////////////////////////////////////////////
+template<typename VertexProperty, typename EdgeProperty>
+class versioned_graph {
+
+  typedef graph_version_data<VertexProperty, EdgeProperty> data;
+  typedef typename data::record record;
+  typedef typename data::chunk chunk;
+
+  public:
+    typedef size_t vertex_descriptor;
+    typedef std::pair<size_t, size_t> edge_descriptor;
+    typedef graph_version<VertexProperty, EdgeProperty> version;
+
+    ///@brief Start from the empty version 0.
+    versioned_graph() : m_published(std::make_shared<const data>()) { }
+
+    ///@brief Start from a copy of g, keeping its descriptors, as version 1.
+    template<typename Graph>
+    explicit versioned_graph(const Graph& g) : versioned_graph() {
+      for(auto vi = g.vertices_cbegin(); vi != g.vertices_cend(); ++vi) {
+        vertex_descriptor vd = (*vi)->descriptor();
+        while(draft().bound <= vd)
+          add_slot();
+        place(vd, (*vi)->property());
+      }
+      for(auto ei = g.edges_cbegin(); ei != g.edges_cend(); ++ei)
+        insert_edge((*ei)->source(), (*ei)->target(), (*ei)->property());
+      commit();
+    }
+
+    versioned_graph(const versioned_graph&) = delete;             ///< Copy is disabled.
+    versioned_graph& operator=(const versioned_graph&) = delete;  ///< Copy is disabled.
+
+    ///@brief The latest committed version, pinned for as long as the result
+    ///       is held. Safe to call from any thread.
+    version pin() const {return version(std::atomic_load(&m_published));}
+
+    ///@brief Number of the latest committed version.
+    uint64_t committed() const {return std::atomic_load(&m_published)->number;}
+
+    ///@brief Whether the draft holds uncommitted changes.
+    bool pending() const {return bool(m_draft);}
+
+    ///@brief Modifiers of the draft, invisible to readers until commit().
+    vertex_descriptor insert_vertex(const VertexProperty& vp) {
+      vertex_descriptor vd = add_slot();
+      place(vd, vp);
+      return vd;
+    }
+
+    edge_descriptor insert_edge(vertex_descriptor sd, vertex_descriptor td, const EdgeProperty& ep) {
+      const record* s = draft().find(sd);
+      if(!s or !draft().find(td) or !out_neighbors(sd, s).insert(td).second)
+        return std::make_pair(sd, td);
+      writable(sd)->out.emplace_back(td, ep);
+      writable(td)->in.push_back(sd);
+      ++draft().num_edges;
+      return std::make_pair(sd, td);
+    }
+
+    void insert_edge_undirected(vertex_descriptor sd, vertex_descriptor td, const EdgeProperty& ep) {
+      insert_edge(sd, td, ep);
+      insert_edge(td, sd, ep);
+    }
+
+    void erase_edge(edge_descriptor ed) {
+      const record* s = draft().find(ed.first);
+      if(!s)
+        return;
+      auto e = std::find_if(s->out.begin(), s->out.end(),
+          [&](const std::pair<size_t, EdgeProperty>& o) {return o.first == ed.second;});
+      if(e == s->out.end())
+        return;
+      record* w = writable(ed.first);
+      w->out.erase(w->out.begin() + (e - s->out.begin()));
+      auto n = m_out_neighbors.find(ed.first);
+      if(n != m_out_neighbors.end())
+        n->second.erase(ed.second);
+      record* t = writable(ed.second);
+      t->in.erase(std::find(t->in.begin(), t->in.end(), ed.first));
+      --draft().num_edges;
+    }
+
+    void erase_vertex(vertex_descriptor vd) {
+      const record* v = draft().find(vd);
+      if(!v)
+        return;
+      // the record itself is dropped, so only its neighbors are rewritten
+      for(const auto& e : v->out)
+        if(e.first != vd) {
+          record* t = writable(e.first);
+          t->in.erase(std::find(t->in.begin(), t->in.end(), vd));
+        }
+      for(size_t s : v->in)
+        if(s != vd) {
+          record* w = writable(s);
+          w->out.erase(std::find_if(w->out.begin(), w->out.end(),
+                [&](const std::pair<size_t, EdgeProperty>& o) {return o.first == vd;}));
+          auto n = m_out_neighbors.find(s);
+          if(n != m_out_neighbors.end())
+            n->second.erase(vd);
+        }
+      m_out_neighbors.erase(vd);
+      bool loop = std::find(v->in.begin(), v->in.end(), vd) != v->in.end();
+      draft().num_edges -= v->out.size() + v->in.size() - loop;
+      --draft().num_vertices;
+      writable_chunk(vd)->slots[vd % data::chunk_size].reset();
+    }
+
+    ///@brief Publish the draft as the next version and return its number;
+    ///       with nothing pending, the number of the current one.
+    uint64_t commit() {
+      if(!m_draft)
+        return m_published->number;
+      uint64_t number = m_draft->number;
+      std::atomic_store(&m_published, std::shared_ptr<const data>(std::move(m_draft)));
+      m_draft.reset();
+      m_out_neighbors.clear();
+      return number;
+    }
+
+    ///@brief Drop the uncommitted changes.
+    void discard() {
+      m_draft.reset();
+      m_out_neighbors.clear();
+    }
+
+  private:
+    // The draft, started as a copy of the published chunk table: one
+    // reference count bump per chunk.
+    data& draft() {
+      if(!m_draft) {
+        m_draft = std::make_shared<data>(*m_published);
+        ++m_draft->number;
+      }
+      return *m_draft;
+    }
+
+    // The chunk holding vd, copied into the draft first if it is shared.
+    chunk* writable_chunk(vertex_descriptor vd) {
+      std::shared_ptr<const chunk>& c = draft().chunks[vd / data::chunk_size];
+      if(c->created != m_draft->number) {
+        auto copy = std::make_shared<chunk>(*c);
+        copy->created = m_draft->number;
+        c = copy;
+      }
+      // created by this draft, so no published version can see it
+      return const_cast<chunk*>(c.get());
+    }
+
+    // The record of vd, which must be present, copied first if it is shared.
+    record* writable(vertex_descriptor vd) {
+      std::shared_ptr<const record>& r = writable_chunk(vd)->slots[vd % data::chunk_size];
+      if(r->created != m_draft->number) {
+        auto copy = std::make_shared<record>(*r);
+        copy->created = m_draft->number;
+        r = copy;
+      }
+      return const_cast<record*>(r.get());
+    }
+
+    // The out-neighbors of sd, whose record is s, indexed on first use.
+    std::unordered_set<vertex_descriptor>& out_neighbors(vertex_descriptor sd, const record* s) {
+      auto n = m_out_neighbors.find(sd);
+      if(n == m_out_neighbors.end()) {
+        n = m_out_neighbors.emplace(sd, std::unordered_set<vertex_descriptor>()).first;
+        n->second.reserve(s->out.size() + 1);
+        for(const auto& e : s->out)
+          n->second.insert(e.first);
+      }
+      return n->second;
+    }
+
+    // Hand out the next descriptor, growing the chunk table as needed.
+    vertex_descriptor add_slot() {
+      data& d = draft();
+      if(d.bound == d.chunks.size() * data::chunk_size) {
+        auto c = std::make_shared<chunk>();
+        c->created = d.number;
+        d.chunks.push_back(c);
+      }
+      return d.bound++;
+    }
+
+    // Put a fresh record for vd, a free slot below the bound.
+    void place(vertex_descriptor vd, const VertexProperty& vp) {
+      auto r = std::make_shared<record>();
+      r->descriptor = vd;
+      r->property = vp;
+      r->created = draft().number;
+      writable_chunk(vd)->slots[vd % data::chunk_size] = r;
+      ++m_draft->num_vertices;
+    }
+
+    std::shared_ptr<const data> m_published; //< Latest committed version; accessed atomically
+    std::shared_ptr<data> m_draft;           //< Uncommitted changes, null if none
+    std::unordered_map<vertex_descriptor, std::unordered_set<vertex_descriptor>>
+      m_out_neighbors;                       //< Draft out-neighbors of sources it inserted from
+};
+
+
+#endif
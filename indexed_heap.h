@@ -0,0 +1,139 @@
+#ifndef _INDEXED_HEAP_H_
+#define _INDEXED_HEAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// A d-ary min-heap of (key, id) pairs over the dense ids [0, capacity), with
+/// a position index so an id's key can be decreased in place. Keys are stored
+/// next to their ids in one array, so sifting compares within the heap array
+/// instead of chasing ids into a separate key table, and the Arity children of
+/// a node are adjacent, so a sift-down step reads one or two cache lines while
+/// the tree is half as deep as a binary heap's. Each id is in the heap at most
+/// once.
+////////////////////////////////////////////////////////////////////////////////
+template<typename Key, size_t Arity = 4, typename Compare = std::less<Key>>
+class indexed_heap {
+  static_assert(Arity >= 2, "a heap needs at least two children per node");
+
+  public:
+    typedef std::pair<Key, size_t> value_type; //< (key, id)
+
+    ///@brief Constructor. Ids must be below capacity.
+    explicit indexed_heap(size_t capacity = 0, const Compare& comp = Compare()) :
+      m_position(capacity, npos), m_comp(comp) { }
+
+    bool empty() const {return m_heap.empty();}
+    size_t size() const {return m_heap.size();}
+    bool contains(size_t id) const {return m_position[id] != npos;}
+
+    ///@brief Current key of an id in the heap.
+    const Key& key(size_t id) const {return m_heap[m_position[id]].first;}
+
+    ///@brief Entry with the smallest key.
+    const value_type& top() const {return m_heap.front();}
+
+    ///@brief Add an id that is not in the heap.
+    void push(size_t id, const Key& k) {
+      m_heap.emplace_back(k, id);
+      m_position[id] = m_heap.size() - 1;
+      sift_up(m_heap.size() - 1);
+    }
+
+    ///@brief Lower the key of an id in the heap; k must not compare greater.
+    void decrease(size_t id, const Key& k) {
+      size_t i = m_position[id];
+      m_heap[i].first = k;
+      sift_up(i);
+    }
+
+    ///@brief Push id, or decrease its key if k improves on it. Returns
+    ///       whether the heap changed.
+    bool push_or_decrease(size_t id, const Key& k) {
+      if(!contains(id)) {
+        push(id, k);
+        return true;
+      }
+      if(m_comp(k, key(id))) {
+        decrease(id, k);
+        return true;
+      }
+      return false;
+    }
+
+    ///@brief Remove the entry with the smallest key.
+    void pop() {
+      m_position[m_heap.front().second] = npos;
+      if(m_heap.size() > 1) {
+        m_heap.front() = std::move(m_heap.back());
+        m_position[m_heap.front().second] = 0;
+      }
+      m_heap.pop_back();
+      if(!m_heap.empty())
+        sift_down(0);
+    }
+
+    ///@brief Empty the heap, keeping its capacity.
+    void clear() {
+      for(const value_type& e : m_heap)
+        m_position[e.second] = npos;
+      m_heap.clear();
+    }
+
+  private:
+    static constexpr size_t npos = size_t(-1);
+
+    // Move the entry at i towards the root while it beats its parent. The
+    // entry is held aside and written once at its final position.
+    void sift_up(size_t i) {
+      value_type e = std::move(m_heap[i]);
+      while(i > 0) {
+        size_t parent = (i - 1) / Arity;
+        if(!m_comp(e.first, m_heap[parent].first))
+          break;
+        place(i, std::move(m_heap[parent]));
+        i = parent;
+      }
+      place(i, std::move(e));
+    }
+
+    // Move the entry at i towards the leaves while a child beats it.
+    void sift_down(size_t i) {
+      value_type e = std::move(m_heap[i]);
+      const size_t n = m_heap.size();
+      for(;;) {
+        size_t first = Arity * i + 1;
+        if(first >= n)
+          break;
+        size_t best = first;
+        for(size_t c = first + 1, last = std::min(first + Arity, n); c < last; ++c)
+          if(m_comp(m_heap[c].first, m_heap[best].first))
+            best = c;
+        if(!m_comp(m_heap[best].first, e.first))
+          break;
+        place(i, std::move(m_heap[best]));
+        i = best;
+      }
+      place(i, std::move(e));
+    }
+
+    void place(size_t i, value_type&& e) {
+      m_position[e.second] = i;
+      m_heap[i] = std::move(e);
+    }
+
+    std::vector<value_type> m_heap;   //< Implicit d-ary tree of (key, id)
+    std::vector<size_t> m_position;   //< Id -> index in m_heap, npos if absent
+    Compare m_comp;                   //< Strict weak order on keys
+};
+
+template<typename Key, size_t Arity, typename Compare>
+  constexpr size_t indexed_heap<Key, Arity, Compare>::npos;
+
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef _NODE_POOL_H_
+#define _NODE_POOL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "graph_stats.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// A slab allocator for fixed-size nodes. Nodes are carved out of contiguous
+/// blocks that grow geometrically, freed nodes are recycled through an
+/// intrusive free list, and release() hands every block back to the heap in
+/// O(blocks) without visiting individual nodes.
+///
+/// The pool only manages storage: create() constructs a node and destroy()
+/// runs its destructor. Before release() the owner is responsible for
+/// destroying any live node whose destructor is not trivial.
+////////////////////////////////////////////////////////////////////////////////
+template<typename T>
+class node_pool {
+
+  // Storage for one node, reused as a free-list link while the node is dead.
+  union slot {
+    slot* m_next;
+    typename std::aligned_storage<sizeof(T), alignof(T)>::type m_storage;
+  };
+
+  public:
+
+    ///@brief Constructor/destructor
+    explicit node_pool(size_t first_block = 64, size_t max_block = 8192) :
+      m_free(nullptr), m_cursor(nullptr), m_limit(nullptr),
+      m_free_count(0), m_next_block(first_block), m_max_block(max_block),
+      m_block_allocations(0), m_node_allocations(0) { }
+
+    ~node_pool() {
+      release();
+    }
+
+    node_pool(const node_pool&) = delete;             ///< Copy is disabled.
+    node_pool& operator=(const node_pool&) = delete;  ///< Copy is disabled.
+
+    ///@brief Construct a node in pooled storage.
+    template<typename... Args>
+    T* create(Args&&... args) {
+      slot* s = m_free;
+      if(s) {
+        m_free = s->m_next;
+        --m_free_count;
+      }
+      else {
+        if(m_cursor == m_limit)
+          grow(m_next_block);
+        s = m_cursor++;
+      }
+      ++m_node_allocations;
+      return ::new(static_cast<void*>(&s->m_storage)) T(std::forward<Args>(args)...);
+    }
+
+    ///@brief Make sure the next n creates need no more than one new block.
+    ///       Free-listed nodes and the rest of the current block count toward
+    ///       n, so only the shortfall is allocated.
+    void reserve(size_t n) {
+      size_t available = m_free_count + size_t(m_limit - m_cursor);
+      if(available < n)
+        grow(n - available);
+    }
+
+    ///@brief Destroy a node and put its storage on the free list.
+    void destroy(T* t) {
+      t->~T();
+      slot* s = reinterpret_cast<slot*>(t);
+      s->m_next = m_free;
+      m_free = s;
+      ++m_free_count;
+    }
+
+    ///@brief Return every block to the heap. Live nodes are not destroyed.
+    void release() {
+      for(slot* b : m_blocks)
+        ::operator delete(static_cast<void*>(b));
+      m_blocks.clear();
+      m_free = m_cursor = m_limit = nullptr;
+      m_free_count = 0;
+    }
+
+    ///@brief Number of blocks requested from the heap so far.
+    size_t block_allocations() const {return m_block_allocations;}
+
+    ///@brief Number of nodes handed out so far, i.e. the heap allocations a
+    ///       plain new/delete scheme would have made.
+    size_t node_allocations() const {return m_node_allocations;}
+
+  private:
+    void grow(size_t n) {
+      // the unused tail of the current block goes on the free list
+      for(; m_cursor != m_limit; ++m_cursor) {
+        m_cursor->m_next = m_free;
+        m_free = m_cursor;
+        ++m_free_count;
+      }
+      GRAPH_STAT_ADD(allocations, 1);
+      slot* b = static_cast<slot*>(::operator new(n * sizeof(slot)));
+      m_blocks.push_back(b);
+      m_cursor = b;
+      m_limit = b + n;
+      m_next_block = std::min(2 * m_next_block, m_max_block);
+      ++m_block_allocations;
+    }
+
+    std::vector<slot*> m_blocks; //< Every block owned by the pool
+    slot* m_free;                //< Head of the free list
+    slot* m_cursor;              //< Next never-used slot in the newest block
+    slot* m_limit;               //< End of the newest block
+    size_t m_free_count;         //< Length of the free list
+    size_t m_next_block;         //< Size in nodes of the next block
+    size_t m_max_block;          //< Cap on block growth
+    size_t m_block_allocations;  //< Blocks requested from the heap
+    size_t m_node_allocations;   //< Nodes handed out
+};
+
+
+#endif
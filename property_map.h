@@ -0,0 +1,154 @@
+#ifndef _PROPERTY_MAP_H_
+#define _PROPERTY_MAP_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+
+// Property maps are the outputs of the algorithms in graph_algorithms.h and
+// graph_parallel_algorithms.h: a ParentMap, DistanceMap or ComponentMap from
+// vertex descriptors to values. Any container with clear(), operator[] and
+// mapped_type works, std::unordered_map included. Descriptors are near-dense
+// in practice - the graphs hand them out in order and erase_vertex only
+// leaves holes - so vector_property_map indexes a vector by descriptor
+// instead of hashing into nodes.
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// A map from descriptors to T backed by a vector indexed by descriptor, with
+/// a bitmap of the descriptors that hold a value, so the holes left by
+/// erased vertices read as absent. operator[] grows the vector on demand and,
+/// like std::unordered_map, value-initializes an absent entry; sizing it up
+/// front with the descriptor bound avoids the regrowth. Iteration visits the
+/// present entries in descriptor order as (descriptor, value) pairs.
+////////////////////////////////////////////////////////////////////////////////
+template<typename Key, typename T>
+class vector_property_map {
+  public:
+    typedef Key key_type;
+    typedef T mapped_type;
+    typedef std::pair<Key, T> value_type;
+
+    class const_iterator {
+      public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef std::pair<Key, T> value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef value_type reference;
+
+        const_iterator() : m_map(nullptr), m_key(0) { }
+
+        value_type operator*() const {return value_type(Key(m_key), m_map->m_values[m_key]);}
+        const_iterator& operator++() {
+          ++m_key;
+          skip_absent();
+          return *this;
+        }
+        const_iterator operator++(int) {
+          const_iterator i = *this;
+          ++*this;
+          return i;
+        }
+        bool operator==(const const_iterator& i) const {return m_key == i.m_key;}
+        bool operator!=(const const_iterator& i) const {return m_key != i.m_key;}
+
+      private:
+        const_iterator(const vector_property_map* m, size_t k) : m_map(m), m_key(k) { }
+
+        void skip_absent() {
+          while(m_key < m_map->bound() and !m_map->present(m_key))
+            ++m_key;
+        }
+
+        const vector_property_map* m_map; //< Iterated map
+        size_t m_key;                     //< Current descriptor
+
+        friend class vector_property_map;
+    };
+    typedef const_iterator iterator;
+
+    ///@brief Constructor. bound is one past the largest descriptor expected.
+    explicit vector_property_map(size_t bound = 0) : m_size(0) {
+      reserve(bound);
+    }
+
+    ///@brief Iterators
+    const_iterator begin() const {
+      const_iterator i(this, 0);
+      i.skip_absent();
+      return i;
+    }
+    const_iterator end() const {return const_iterator(this, bound());}
+
+    ///@brief Capacity
+    size_t size() const {return m_size;}
+    bool empty() const {return m_size == 0;}
+    size_t bound() const {return m_values.size();}
+
+    ///@brief Make room for descriptors below bound.
+    void reserve(size_t bound) {
+      if(bound > m_values.size()) {
+        m_values.resize(bound);
+        m_present.resize((bound + 63) / 64, 0);
+      }
+    }
+
+    ///@brief Lookup
+    size_t count(Key k) const {return size_t(k) < bound() and present(k);}
+    const_iterator find(Key k) const {return count(k) ? const_iterator(this, k) : end();}
+
+    ///@brief Value of a present descriptor.
+    const T& at(Key k) const {return m_values[k];}
+
+    ///@brief Value of k, value-initialized and marked present if absent.
+    T& operator[](Key k) {
+      size_t i = k;
+      if(i >= bound())
+        reserve(std::max(i + 1, 2 * bound()));
+      if(!present(i)) {
+        m_present[i >> 6] |= uint64_t(1) << (i & 63);
+        m_values[i] = T();
+        ++m_size;
+      }
+      return m_values[i];
+    }
+
+    size_t erase(Key k) {
+      if(!count(k))
+        return 0;
+      m_present[size_t(k) >> 6] &= ~(uint64_t(1) << (size_t(k) & 63));
+      --m_size;
+      return 1;
+    }
+
+    ///@brief Remove every entry, keeping the storage.
+    void clear() {
+      std::fill(m_present.begin(), m_present.end(), 0);
+      m_size = 0;
+    }
+
+    bool operator==(const vector_property_map& o) const {
+      if(m_size != o.m_size)
+        return false;
+      for(const_iterator i = begin(); i != end(); ++i)
+        if(!o.count((*i).first) or !(o.at((*i).first) == (*i).second))
+          return false;
+      return true;
+    }
+    bool operator!=(const vector_property_map& o) const {return !(*this == o);}
+
+  private:
+    bool present(size_t i) const {return (m_present[i >> 6] >> (i & 63)) & 1;}
+
+    std::vector<T> m_values;         //< Descriptor -> value, meaningful if present
+    std::vector<uint64_t> m_present; //< Bitmap of descriptors holding a value
+    size_t m_size;                   //< Present entries
+};
+
+
+#endif
@@ -0,0 +1,177 @@
+#ifndef _SMALL_VECTOR_H_
+#define _SMALL_VECTOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "graph_stats.h"
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// A vector that keeps its first N elements inside the object and moves to
+/// the heap only when it outgrows them. A low-degree vertex's adjacency list
+/// then costs no allocation and sits in the vertex's own cache lines. The
+/// interface is the subset of std::vector the graphs use; iterators are
+/// pointers and, as for std::vector, are invalidated when the storage moves.
+////////////////////////////////////////////////////////////////////////////////
+template<typename T, size_t N>
+class small_vector {
+  static_assert(N > 0, "use std::vector for no inline storage");
+
+  public:
+    typedef T value_type;
+    typedef T* iterator;
+    typedef const T* const_iterator;
+    typedef size_t size_type;
+
+    ///@brief Constructors/destructor
+    small_vector() : m_data(inline_data()), m_size(0), m_capacity(N) { }
+
+    small_vector(const small_vector& o) : small_vector() {
+      reserve(o.size());
+      for(const T& x : o)
+        push_back(x);
+    }
+
+    small_vector(small_vector&& o) noexcept : small_vector() {
+      take(o);
+    }
+
+    small_vector& operator=(const small_vector& o) {
+      if(this != &o) {
+        clear();
+        reserve(o.size());
+        for(const T& x : o)
+          push_back(x);
+      }
+      return *this;
+    }
+
+    small_vector& operator=(small_vector&& o) noexcept {
+      if(this != &o) {
+        clear();
+        release();
+        take(o);
+      }
+      return *this;
+    }
+
+    ~small_vector() {
+      clear();
+      release();
+    }
+
+    ///@brief Iterators
+    iterator begin() {return m_data;}
+    iterator end() {return m_data + m_size;}
+    const_iterator begin() const {return m_data;}
+    const_iterator end() const {return m_data + m_size;}
+    const_iterator cbegin() const {return begin();}
+    const_iterator cend() const {return end();}
+
+    ///@brief Capacity
+    size_t size() const {return m_size;}
+    bool empty() const {return m_size == 0;}
+    size_t capacity() const {return m_capacity;}
+    bool is_inline() const {return m_data == inline_data();}
+
+    void reserve(size_t n) {
+      if(n > m_capacity)
+        relocate(std::max(n, 2 * m_capacity));
+    }
+
+    ///@brief Element access
+    T& operator[](size_t i) {return m_data[i];}
+    const T& operator[](size_t i) const {return m_data[i];}
+    T& back() {return m_data[m_size - 1];}
+    const T& back() const {return m_data[m_size - 1];}
+
+    ///@brief Modifiers
+    void push_back(const T& x) {
+      if(m_size == m_capacity) {
+        T copy(x); // x may live in this vector
+        relocate(2 * m_capacity);
+        new(m_data + m_size) T(std::move(copy));
+      }
+      else
+        new(m_data + m_size) T(x);
+      ++m_size;
+    }
+
+    void pop_back() {
+      m_data[--m_size].~T();
+    }
+
+    iterator erase(iterator first, iterator last) {
+      iterator e = std::move(last, end(), first);
+      for(iterator i = e; i != end(); ++i)
+        i->~T();
+      m_size = e - m_data;
+      return first;
+    }
+
+    iterator erase(iterator pos) {return erase(pos, pos + 1);}
+
+    ///@brief Destroy the elements, keeping the storage.
+    void clear() {
+      for(size_t i = 0; i < m_size; ++i)
+        m_data[i].~T();
+      m_size = 0;
+    }
+
+  private:
+    T* inline_data() {return reinterpret_cast<T*>(&m_inline);}
+    const T* inline_data() const {return reinterpret_cast<const T*>(&m_inline);}
+
+    // Move the elements to a heap block of the given capacity.
+    void relocate(size_t capacity) {
+      GRAPH_STAT_ADD(allocations, 1);
+      T* data = static_cast<T*>(::operator new(capacity * sizeof(T)));
+      for(size_t i = 0; i < m_size; ++i) {
+        new(data + i) T(std::move(m_data[i]));
+        m_data[i].~T();
+      }
+      release();
+      m_data = data;
+      m_capacity = capacity;
+    }
+
+    // Free a heap block; the elements must already be gone.
+    void release() {
+      if(!is_inline())
+        ::operator delete(m_data);
+      m_data = inline_data();
+      m_capacity = N;
+    }
+
+    // Steal o's heap block, or move its inline elements; this must be empty
+    // and inline.
+    void take(small_vector& o) {
+      if(o.is_inline()) {
+        for(size_t i = 0; i < o.m_size; ++i)
+          new(m_data + i) T(std::move(o.m_data[i]));
+        m_size = o.m_size;
+        o.clear();
+      }
+      else {
+        m_data = o.m_data;
+        m_size = o.m_size;
+        m_capacity = o.m_capacity;
+        o.m_data = o.inline_data();
+        o.m_size = 0;
+        o.m_capacity = N;
+      }
+    }
+
+    T* m_data;          //< Inline buffer or heap block
+    size_t m_size;      //< Elements
+    size_t m_capacity;  //< Elements that fit in m_data
+    typename std::aligned_storage<sizeof(T) * N, alignof(T)>::type m_inline; //< First N elements
+};
+
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef _THREAD_TEAM_H_
+#define _THREAD_TEAM_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// A fixed team of worker threads for fork-join parallel loops. run(f) calls
+/// f(tid) once for every tid in [0, size()) - the calling thread takes tid 0 -
+/// and returns when all calls have finished. Workers sleep between runs, so a
+/// team can be reused across the many short phases of a level-synchronous
+/// algorithm without paying for thread creation each time.
+////////////////////////////////////////////////////////////////////////////////
+class thread_team {
+  public:
+
+    ///@brief Constructor/destructor. A size of 0 means one thread per core.
+    explicit thread_team(size_t n = 0) :
+      m_size(n ? n : std::max(1u, std::thread::hardware_concurrency())),
+      m_task(nullptr), m_generation(0), m_pending(0), m_stop(false) {
+      for(size_t tid = 1; tid < m_size; ++tid)
+        m_workers.emplace_back([this, tid] {work(tid);});
+    }
+
+    ~thread_team() {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+      }
+      m_wake.notify_all();
+      for(auto& w : m_workers)
+        w.join();
+    }
+
+    thread_team(const thread_team&) = delete;             ///< Copy is disabled.
+    thread_team& operator=(const thread_team&) = delete;  ///< Copy is disabled.
+
+    size_t size() const {return m_size;}
+
+    ///@brief Call f(tid) on every thread of the team and wait for all.
+    void run(const std::function<void(size_t)>& f) {
+      if(m_size == 1) {
+        f(0);
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_task = &f;
+        m_pending = m_size - 1;
+        ++m_generation;
+      }
+      m_wake.notify_all();
+      f(0);
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_done.wait(lock, [this] {return m_pending == 0;});
+      m_task = nullptr;
+    }
+
+    ///@brief Run body(i, tid) for every i in [first, last), handing out
+    ///       chunks of the range dynamically.
+    template<typename Body>
+    void parallel_for(size_t first, size_t last, size_t chunk, Body body) {
+      std::atomic<size_t> next(first);
+      run([&](size_t tid) {
+        for(size_t b = next.fetch_add(chunk); b < last; b = next.fetch_add(chunk))
+          for(size_t i = b, e = std::min(last, b + chunk); i < e; ++i)
+            body(i, tid);
+      });
+    }
+
+  private:
+    void work(size_t tid) {
+      size_t seen = 0;
+      for(;;) {
+        const std::function<void(size_t)>* task;
+        {
+          std::unique_lock<std::mutex> lock(m_mutex);
+          m_wake.wait(lock, [&] {return m_stop or m_generation != seen;});
+          if(m_stop)
+            return;
+          seen = m_generation;
+          task = m_task;
+        }
+        (*task)(tid);
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          if(--m_pending == 0)
+            m_done.notify_one();
+        }
+      }
+    }
+
+    size_t m_size;                                //< Threads including the caller
+    std::vector<std::thread> m_workers;           //< Threads 1..size-1
+    std::mutex m_mutex;                           //< Guards the fields below
+    std::condition_variable m_wake;               //< Signals a new run or shutdown
+    std::condition_variable m_done;               //< Signals the end of a run
+    const std::function<void(size_t)>* m_task;   //< Current run
+    size_t m_generation;                          //< Number of runs started
+    size_t m_pending;                             //< Workers still in the current run
+    bool m_stop;                                  //< Set on destruction
+};
+
+
+#endif
@@ -1,6 +1,14 @@
 #include "graph.h"
 #include "graph_algorithms.h"
+#include "graph_csr.h"
+#include "graph_compressed.h"
+#include "edge_store.h"
+#include "graph_parallel_algorithms.h"
 #include "graph_dumb_vector.h"
+#include "graph_generators.h"
+#include "graph_versioned.h"
+#include "graph_stats.h"
+#include "property_map.h"
 
 #include <chrono>
 #include <climits>
@@ -8,110 +16,204 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <unordered_map>
 #include <string>
+#include <thread>
 #include <utility>
 using namespace std;
 using namespace chrono;
 
-/// @brief create a complete graph of size n
+///@brief Report heap traffic of the pooled set graph; other graphs have none
 template <typename graph_id>
-void initialize_complete_graph(graph_id &g, size_t n)
-{
-    // add vertices
-    for (size_t i = 0; i < n; ++i)
-        g.insert_vertex(i);
-
-    // add edges
+void print_allocations(const graph_id &) {}
 
-    typedef typename graph_id::const_vertex_iterator CVI;
-
-    for (CVI vi1 = g.vertices_cbegin(); vi1 != g.vertices_cend(); ++vi1)
-        for (CVI vi2 = g.vertices_cbegin(); vi2 != g.vertices_cend(); ++vi2)
-            if ((*vi1)->descriptor() != (*vi2)->descriptor())
-                g.insert_edge((*vi1)->descriptor(), (*vi2)->descriptor(), double(rand()) / RAND_MAX);
+template <typename V, typename E, size_t N>
+void print_allocations(const graph<V, E, N> &g)
+{
+    cout << "\tAllocs: " << g.block_allocations() << "/" << g.node_allocations();
 }
 
-/// @brief create a mesh of size n
-template <typename graph_id>
-void initialize_mesh_graph(graph_id &g, size_t n)
+///@brief Counters of one timed phase. Built with GRAPH_STATS (make STATS=1)
+///       print() appends the phase's graph_stats and, where the kernel allows,
+///       its hardware counters; otherwise it prints nothing.
+class phase_stats
 {
-    // make n a square number
-    size_t rootn = sqrt(n);
-    n = rootn * rootn;
-
-    // add vertices
-    for (size_t i = 0; i < n; ++i)
-        g.insert_vertex(i);
-
-    // add edges
-    for (size_t i = 0; i < n; ++i)
+public:
+    phase_stats() : m_start(read_graph_stats())
     {
-        size_t x = i + 1;
-        size_t y = i + rootn;
-
-        if (x % rootn != 0)
-            g.insert_edge_undirected(i, x, double(rand()) / RAND_MAX);
-
-        if (y < n)
-            g.insert_edge_undirected(i, y, double(rand()) / RAND_MAX);
+        m_perf.start();
     }
-}
-
-/// @brief create a mesh of size n
-template <typename graph_id>
-void initialize_random_graph(graph_id &g, size_t n)
-{
-    // add vertices
-    for (size_t i = 0; i < n; ++i)
-        g.insert_vertex(i);
-
-    // add edges for connectivity
-    for (size_t i = 0; i < n - 1; ++i)
-        g.insert_edge_undirected(i, i + 1, double(rand()) / RAND_MAX);
 
-    size_t num_edges = n * sqrt(n) / 2;
-    for (size_t i = 0; i < num_edges; ++i)
+    void print()
     {
-        size_t s = rand() % n;
-        size_t t = rand() % n;
-        if (s != t)
-            g.insert_edge_undirected(s, t, double(rand()) / RAND_MAX);
-        else
-            --i;
+        m_perf.stop();
+        if (!graph_stats_enabled)
+            return;
+        graph_stats d = read_graph_stats() - m_start;
+        cout << " [lookups " << d.hash_lookups << " probes " << d.hash_probes << " rehashes " << d.rehashes
+             << " scans " << d.scan_lookups << "/" << d.scan_steps << " allocs " << d.allocations
+             << " visited " << d.vertices_visited << " examined " << d.edges_examined;
+        if (m_perf.available())
+            cout << " cycles " << m_perf.cycles() << " cache-misses " << m_perf.cache_misses()
+                 << " branch-misses " << m_perf.branch_misses();
+        cout << "]";
     }
-}
+
+private:
+    graph_stats m_start; //< Counters when the phase began
+    perf_counters m_perf; //< Hardware counters of the phase
+};
 
 ///@brief Time functions of a graph
 template <typename graph_id, typename Initializer>
 void time_graph(Initializer i, size_t n)
 {
     cout << "\tGraph Size: " << n;
+    phase_stats create_stats;
     high_resolution_clock::time_point create_start = high_resolution_clock::now();
     // create graph, testing insertion
     graph_id g;
     i(g, n);
     high_resolution_clock::time_point create_stop = high_resolution_clock::now();
     cout << "\tCreate: " << duration_cast<duration<double>>(create_stop - create_start).count();
+    create_stats.print();
+    print_allocations(g);
 
+    phase_stats bfs_stats;
     high_resolution_clock::time_point bfs_start = high_resolution_clock::now();
     // run BFS
     typedef typename graph_id::vertex_descriptor vertex_descriptor;
-    unordered_map<vertex_descriptor, vertex_descriptor> parent_map;
+    vector_property_map<vertex_descriptor, vertex_descriptor> parent_map;
     breadth_first_search(g, parent_map);
     high_resolution_clock::time_point bfs_stop = high_resolution_clock::now();
     cout << "\tBFS: " << duration_cast<duration<double>>(bfs_stop - bfs_start).count();
+    bfs_stats.print();
 
-    high_resolution_clock::time_point erase_start = high_resolution_clock::now();
+    // take the first 100 vertices of a lazy BFS from the first vertex
+    high_resolution_clock::time_point lazy_start = high_resolution_clock::now();
+    size_t taken = 0, reached_depth = 0;
+    for (const auto &step : breadth_first_range(g, (*g.vertices_cbegin())->descriptor()))
+    {
+        reached_depth = step.depth;
+        if (++taken == 100)
+            break;
+    }
+    high_resolution_clock::time_point lazy_stop = high_resolution_clock::now();
+    cout << "\tLazy BFS: " << duration_cast<duration<double>>(lazy_stop - lazy_start).count()
+         << " (first " << taken << " to depth " << reached_depth << ")";
+
+    // depths from 64 sources: one search each, then one bit-parallel batch
+    vector<vertex_descriptor> sources;
+    for (auto vi = g.vertices_cbegin(); vi != g.vertices_cend() && sources.size() < 64; ++vi)
+        sources.push_back((*vi)->descriptor());
+    vector<vector_property_map<vertex_descriptor, size_t>> depths(sources.size());
+    high_resolution_clock::time_point each_start = high_resolution_clock::now();
+    for (size_t s = 0; s < sources.size(); ++s)
+    {
+        depths[s].clear();
+        for (const auto &step : breadth_first_range(g, sources[s]))
+            depths[s][step.vertex] = step.depth;
+    }
+    high_resolution_clock::time_point each_stop = high_resolution_clock::now();
+    cout << "\t64 BFS: " << duration_cast<duration<double>>(each_stop - each_start).count();
+
+    high_resolution_clock::time_point msbfs_start = high_resolution_clock::now();
+    multi_source_breadth_first_search(g, sources, depths);
+    high_resolution_clock::time_point msbfs_stop = high_resolution_clock::now();
+    cout << "\tMS-BFS: " << duration_cast<duration<double>>(msbfs_stop - msbfs_start).count();
+
+    // run direction-optimizing BFS, reporting the edges it inspected
+    high_resolution_clock::time_point dobfs_start = high_resolution_clock::now();
+    size_t inspected = direction_optimizing_breadth_first_search(g, parent_map);
+    high_resolution_clock::time_point dobfs_stop = high_resolution_clock::now();
+    cout << "\tDO-BFS: " << duration_cast<duration<double>>(dobfs_stop - dobfs_start).count()
+         << " (" << inspected << "/" << g.num_edges() << " edges)";
+
+    // freeze into a CSR snapshot and run both searches on it
+    high_resolution_clock::time_point freeze_start = high_resolution_clock::now();
+    graph_csr<int, double> csr(g);
+    high_resolution_clock::time_point freeze_stop = high_resolution_clock::now();
+    cout << "\tFreeze: " << duration_cast<duration<double>>(freeze_stop - freeze_start).count();
+
+    high_resolution_clock::time_point csr_bfs_start = high_resolution_clock::now();
+    parent_map.clear();
+    breadth_first_search(csr, parent_map);
+    high_resolution_clock::time_point csr_bfs_stop = high_resolution_clock::now();
+    cout << "\tCSR BFS: " << duration_cast<duration<double>>(csr_bfs_stop - csr_bfs_start).count();
+
+    high_resolution_clock::time_point csr_dfs_start = high_resolution_clock::now();
+    parent_map.clear();
+    depth_first_search(csr, parent_map);
+    high_resolution_clock::time_point csr_dfs_stop = high_resolution_clock::now();
+    cout << "\tCSR DFS: " << duration_cast<duration<double>>(csr_dfs_stop - csr_dfs_start).count();
+
+    // compress, reporting bytes per edge, and search the compressed form
+    high_resolution_clock::time_point compress_start = high_resolution_clock::now();
+    graph_compressed<int, double> compressed(g);
+    high_resolution_clock::time_point compress_stop = high_resolution_clock::now();
+    cout << "\tCompress: " << duration_cast<duration<double>>(compress_stop - compress_start).count()
+         << " (" << double(compressed.memory_bytes()) / max<size_t>(1, g.num_edges()) << " B/edge)";
+
+    high_resolution_clock::time_point compressed_bfs_start = high_resolution_clock::now();
+    parent_map.clear();
+    breadth_first_search(compressed, parent_map);
+    high_resolution_clock::time_point compressed_bfs_stop = high_resolution_clock::now();
+    cout << "\tCompressed BFS: " << duration_cast<duration<double>>(compressed_bfs_stop - compressed_bfs_start).count();
 
     // run DFS
+    phase_stats dfs_stats;
     high_resolution_clock::time_point dfs_start = high_resolution_clock::now();
     parent_map.clear();
     depth_first_search(g, parent_map);
     high_resolution_clock::time_point dfs_stop = high_resolution_clock::now();
     cout << "\tDFS: " << duration_cast<duration<double>>(dfs_stop - dfs_start).count();
+    dfs_stats.print();
+
+    // run Dijkstra from the first vertex over the double weights
+    phase_stats sssp_stats;
+    high_resolution_clock::time_point sssp_start = high_resolution_clock::now();
+    vector_property_map<vertex_descriptor, double> distance_map;
+    dijkstra_shortest_paths(g, (*g.vertices_cbegin())->descriptor(), parent_map, distance_map);
+    high_resolution_clock::time_point sssp_stop = high_resolution_clock::now();
+    cout << "\tDijkstra: " << duration_cast<duration<double>>(sssp_stop - sssp_start).count();
+    sssp_stats.print();
+
+    // the same search over a structure-of-arrays copy of the edges
+    high_resolution_clock::time_point soa_start = high_resolution_clock::now();
+    edge_store<double> store(g);
+    high_resolution_clock::time_point soa_sssp_start = high_resolution_clock::now();
+    dijkstra_shortest_paths(store, (*g.vertices_cbegin())->descriptor(), parent_map, distance_map);
+    high_resolution_clock::time_point soa_sssp_stop = high_resolution_clock::now();
+    cout << "\tEdge store: " << duration_cast<duration<double>>(soa_sssp_start - soa_start).count()
+         << "\tSoA Dijkstra: " << duration_cast<duration<double>>(soa_sssp_stop - soa_sssp_start).count();
+
+    // copy into a versioned graph, search a pinned version, then ingest 1%
+    // more edges as one commit
+    high_resolution_clock::time_point version_start = high_resolution_clock::now();
+    versioned_graph<int, double> versioned(g);
+    graph_version<int, double> pinned = versioned.pin();
+    high_resolution_clock::time_point pinned_bfs_start = high_resolution_clock::now();
+    breadth_first_search(pinned, parent_map);
+    high_resolution_clock::time_point ingest_start = high_resolution_clock::now();
+    rng_stream ingest(0, 0);
+    for (size_t i = 0; i <= g.num_edges() / 100; ++i)
+        versioned.insert_edge(ingest.below(g.num_vertices()), ingest.below(g.num_vertices()), 1.0);
+    versioned.commit();
+    high_resolution_clock::time_point ingest_stop = high_resolution_clock::now();
+    cout << "\tVersioned copy: " << duration_cast<duration<double>>(pinned_bfs_start - version_start).count()
+         << "\tPinned BFS: " << duration_cast<duration<double>>(ingest_start - pinned_bfs_start).count()
+         << "\tIngest 1%: " << duration_cast<duration<double>>(ingest_stop - ingest_start).count();
+
+    // label connected components
+    phase_stats cc_stats;
+    high_resolution_clock::time_point cc_start = high_resolution_clock::now();
+    connected_components(g, parent_map);
+    high_resolution_clock::time_point cc_stop = high_resolution_clock::now();
+    cout << "\tCC: " << duration_cast<duration<double>>(cc_stop - cc_start).count();
+    cc_stats.print();
 
     // test erase operations
+    phase_stats erase_stats;
+    high_resolution_clock::time_point erase_start = high_resolution_clock::now();
     size_t quarter_edge = g.num_edges() / 4;
     for (size_t i = 0; i < quarter_edge; ++i)
     {
@@ -132,7 +234,9 @@ void time_graph(Initializer i, size_t n)
             --i;
     }
     high_resolution_clock::time_point erase_stop = high_resolution_clock::now();
-    cout << "\tErase: " << duration_cast<duration<double>>(erase_stop - erase_start).count() << endl;
+    cout << "\tErase: " << duration_cast<duration<double>>(erase_stop - erase_start).count();
+    erase_stats.print();
+    cout << endl;
 }
 
 /// @brief Control timing of a single function
@@ -150,6 +254,48 @@ void time_function(Func f, size_t graph_size, string name)
         time_graph<graphID, Func>(f, gs);
 }
 
+///@brief Strong scaling of the parallel searches on one graph, 1..N threads
+template <typename graph_id, typename Initializer>
+void time_parallel(Initializer i, size_t n, string name)
+{
+    cout << "Graph type: " << name << "\tGraph Size: " << n << endl;
+    graph_id g;
+    i(g, n);
+
+    typedef typename graph_id::vertex_descriptor vertex_descriptor;
+    vector_property_map<vertex_descriptor, vertex_descriptor> parent_map;
+    vector_property_map<vertex_descriptor, double> distance_map;
+    size_t max_threads = max(1u, thread::hardware_concurrency());
+    for (size_t t = 1;; t = min(2 * t, max_threads))
+    {
+        thread_team team(t);
+        cout << "\tThreads: " << t;
+
+        high_resolution_clock::time_point pbfs_start = high_resolution_clock::now();
+        parallel_breadth_first_search(g, parent_map, team);
+        high_resolution_clock::time_point pbfs_stop = high_resolution_clock::now();
+        cout << "\tParallel BFS: " << duration_cast<duration<double>>(pbfs_stop - pbfs_start).count();
+
+        high_resolution_clock::time_point forest_start = high_resolution_clock::now();
+        parallel_spanning_forest(g, parent_map, team);
+        high_resolution_clock::time_point forest_stop = high_resolution_clock::now();
+        cout << "\tSpanning forest: " << duration_cast<duration<double>>(forest_stop - forest_start).count();
+
+        high_resolution_clock::time_point sssp_start = high_resolution_clock::now();
+        parallel_delta_stepping(g, (*g.vertices_cbegin())->descriptor(), parent_map, distance_map, team);
+        high_resolution_clock::time_point sssp_stop = high_resolution_clock::now();
+        cout << "\tDelta-stepping: " << duration_cast<duration<double>>(sssp_stop - sssp_start).count();
+
+        high_resolution_clock::time_point cc_start = high_resolution_clock::now();
+        parallel_connected_components(g, parent_map, team);
+        high_resolution_clock::time_point cc_stop = high_resolution_clock::now();
+        cout << "\tAfforest: " << duration_cast<duration<double>>(cc_stop - cc_start).count() << endl;
+
+        if (t == max_threads)
+            break;
+    }
+}
+
 /// @brief Main function to time all your functions
 int main(int argc, char **argv)
 {
@@ -173,9 +319,15 @@ int main(int argc, char **argv)
     time_function<graph_set_type>(initialize_complete_graph<graph_set_type>, complete_size, "Complete");
     time_function<graph_set_type>(initialize_mesh_graph<graph_set_type>, mesh_size, "Mesh");
     time_function<graph_set_type>(initialize_random_graph<graph_set_type>, random_size, "Random");
+    time_function<graph_set_type>(initialize_rmat_graph<graph_set_type>, random_size, "R-MAT");
 
     cout << "\n\n--------------\nVECTOR GRAPH:\n--------------\n";
     time_function<graph_vector_type>(initialize_complete_graph<graph_vector_type>, complete_size, "Complete");
     time_function<graph_vector_type>(initialize_mesh_graph<graph_vector_type>, mesh_size, "Mesh");
     time_function<graph_vector_type>(initialize_random_graph<graph_vector_type>, random_size, "Random");
+    time_function<graph_vector_type>(initialize_rmat_graph<graph_vector_type>, random_size, "R-MAT");
+
+    cout << "\n\n--------------\nPARALLEL SCALING (SET GRAPH):\n--------------\n";
+    time_parallel<graph_set_type>(initialize_mesh_graph<graph_set_type>, mesh_size, "Mesh");
+    time_parallel<graph_set_type>(initialize_random_graph<graph_set_type>, random_size, "Random");
 }